@@ -0,0 +1,371 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "IndexedAutomata.h"
+#include "MooreAutomata.h"
+
+// Brzozowski minimization of acceptors given as NFAs, ε-moves included: determinizing
+// the reversed automaton twice yields the minimal DFA of the language. Missing transitions
+// lead to an implicit dead state, so states that cannot reach a final state are not materialized.
+class BrzozowskiMinimizer
+{
+public:
+    static MooreAutomata Minimize(const MooreAutomata& automata)
+    {
+        Nfa nfa = FromIndexedAutomata(IndexedAutomata(automata));
+        return ToMooreAutomata(Determinize(Reverse(Determinize(Reverse(nfa)))));
+    }
+
+    // Reachable subset construction alone, the first step of the refinement path for NFAs.
+    static MooreAutomata Determinize(const MooreAutomata& automata)
+    {
+        return ToMooreAutomata(Determinize(FromIndexedAutomata(IndexedAutomata(automata))));
+    }
+
+private:
+    static constexpr uint32_t NO_INPUT = IndexedAutomata::NO_INPUT;
+    static constexpr char NEW_STATE_CHAR = 'X';
+
+    // Targets are stored per (state, input) cell as in IndexedAutomata, a DFA is an Nfa
+    // with one start state and at most one target per cell.
+    struct Nfa
+    {
+        std::vector<std::string> inputs;
+        uint32_t epsilonInput = NO_INPUT;
+        size_t statesCount = 0;
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> targets;
+        std::vector<uint32_t> startStates;
+        std::vector<bool> finalStates;
+
+        [[nodiscard]] std::pair<const uint32_t*, const uint32_t*> GetNextStates(uint32_t state, uint32_t input) const
+        {
+            size_t cell = state * inputs.size() + input;
+            return {targets.data() + offsets[cell], targets.data() + offsets[cell + 1]};
+        }
+    };
+
+    // Subsets of the source states as bitsets in one arena, numbered in insertion order.
+    class SubsetSet
+    {
+    public:
+        explicit SubsetSet(size_t statesCount)
+            : m_words((statesCount + 63) / 64)
+            , m_slots(16, 0)
+        {
+        }
+
+        [[nodiscard]] size_t GetWordsCount() const
+        {
+            return m_words;
+        }
+
+        [[nodiscard]] size_t GetSize() const
+        {
+            return m_count;
+        }
+
+        [[nodiscard]] const uint64_t* Get(uint32_t index) const
+        {
+            return m_bits.data() + index * m_words;
+        }
+
+        // Returns the index of the subset and whether it was added.
+        std::pair<uint32_t, bool> Insert(const uint64_t* subset)
+        {
+            if ((m_count + 1) * 4 > m_slots.size() * 3)
+            {
+                Rehash();
+            }
+
+            size_t mask = m_slots.size() - 1;
+            for (size_t slot = Hash(subset) & mask;; slot = (slot + 1) & mask)
+            {
+                if (m_slots[slot] == 0)
+                {
+                    m_bits.insert(m_bits.end(), subset, subset + m_words);
+                    m_slots[slot] = static_cast<uint32_t>(++m_count);
+                    return {static_cast<uint32_t>(m_count - 1), true};
+                }
+
+                uint32_t index = m_slots[slot] - 1;
+                if (std::memcmp(Get(index), subset, m_words * sizeof(uint64_t)) == 0)
+                {
+                    return {index, false};
+                }
+            }
+        }
+
+    private:
+        [[nodiscard]] uint64_t Hash(const uint64_t* subset) const
+        {
+            uint64_t hash = 0;
+            for (size_t word = 0; word < m_words; ++word)
+            {
+                hash = (hash ^ subset[word]) * 0x9E3779B97F4A7C15ull;
+                hash ^= hash >> 29;
+            }
+
+            return hash;
+        }
+
+        void Rehash()
+        {
+            m_slots.assign(m_slots.size() * 2, 0);
+            size_t mask = m_slots.size() - 1;
+
+            for (uint32_t index = 0; index < m_count; ++index)
+            {
+                size_t slot = Hash(Get(index)) & mask;
+                while (m_slots[slot] != 0)
+                {
+                    slot = (slot + 1) & mask;
+                }
+                m_slots[slot] = index + 1;
+            }
+        }
+
+        size_t m_words;
+        size_t m_count = 0;
+        std::vector<uint64_t> m_bits;
+        std::vector<uint32_t> m_slots;
+    };
+
+    static Nfa FromIndexedAutomata(const IndexedAutomata& automata)
+    {
+        Nfa nfa;
+        nfa.inputs = automata.GetInputs();
+        nfa.epsilonInput = automata.GetEpsilonInput();
+        nfa.statesCount = automata.GetStatesCount();
+        nfa.startStates = {automata.GetStartState()};
+        nfa.finalStates.resize(nfa.statesCount);
+        nfa.offsets.push_back(0);
+
+        for (uint32_t state = 0; state < nfa.statesCount; ++state)
+        {
+            nfa.finalStates[state] = automata.IsFinalState(state);
+            for (uint32_t input = 0; input < nfa.inputs.size(); ++input)
+            {
+                auto nextStates = automata.GetNextStates(state, input);
+                nfa.targets.insert(nfa.targets.end(), nextStates.begin(), nextStates.end());
+                nfa.offsets.push_back(static_cast<uint32_t>(nfa.targets.size()));
+            }
+        }
+
+        return nfa;
+    }
+
+    // Reversed adjacency: every edge is turned around, start and final states swap roles.
+    static Nfa Reverse(const Nfa& nfa)
+    {
+        size_t inputsCount = nfa.inputs.size();
+        Nfa reversed;
+        reversed.inputs = nfa.inputs;
+        reversed.epsilonInput = nfa.epsilonInput;
+        reversed.statesCount = nfa.statesCount;
+        reversed.offsets.assign(nfa.statesCount * inputsCount + 1, 0);
+        reversed.targets.resize(nfa.targets.size());
+
+        for (uint32_t state = 0; state < nfa.statesCount; ++state)
+        {
+            for (uint32_t input = 0; input < inputsCount; ++input)
+            {
+                auto [first, last] = nfa.GetNextStates(state, input);
+                for (auto it = first; it != last; ++it)
+                {
+                    ++reversed.offsets[*it * inputsCount + input + 1];
+                }
+            }
+        }
+
+        for (size_t cell = 1; cell < reversed.offsets.size(); ++cell)
+        {
+            reversed.offsets[cell] += reversed.offsets[cell - 1];
+        }
+
+        std::vector<uint32_t> positions(reversed.offsets.begin(), reversed.offsets.end() - 1);
+        for (uint32_t state = 0; state < nfa.statesCount; ++state)
+        {
+            for (uint32_t input = 0; input < inputsCount; ++input)
+            {
+                auto [first, last] = nfa.GetNextStates(state, input);
+                for (auto it = first; it != last; ++it)
+                {
+                    reversed.targets[positions[*it * inputsCount + input]++] = state;
+                }
+            }
+        }
+
+        reversed.finalStates.assign(nfa.statesCount, false);
+        for (uint32_t state = 0; state < nfa.statesCount; ++state)
+        {
+            if (nfa.finalStates[state])
+            {
+                reversed.startStates.push_back(state);
+            }
+        }
+        for (auto state: nfa.startStates)
+        {
+            reversed.finalStates[state] = true;
+        }
+
+        return reversed;
+    }
+
+    // Subset construction over the reachable subsets only. The empty subset is the
+    // implicit dead state and gets no number unless the start subset itself is empty.
+    static Nfa Determinize(const Nfa& nfa)
+    {
+        SubsetSet subsets(nfa.statesCount);
+        size_t words = subsets.GetWordsCount();
+        std::vector<uint64_t> subset(words);
+        std::vector<uint64_t> finalStates(words);
+        std::vector<uint32_t> stack;
+
+        for (uint32_t state = 0; state < nfa.statesCount; ++state)
+        {
+            if (nfa.finalStates[state])
+            {
+                finalStates[state / 64] |= uint64_t(1) << (state % 64);
+            }
+        }
+
+        Nfa dfa;
+        std::vector<uint32_t> sourceInputs;
+        for (uint32_t input = 0; input < nfa.inputs.size(); ++input)
+        {
+            if (input != nfa.epsilonInput)
+            {
+                dfa.inputs.push_back(nfa.inputs[input]);
+                sourceInputs.push_back(input);
+            }
+        }
+        dfa.startStates = {0};
+        dfa.offsets.push_back(0);
+
+        for (auto state: nfa.startStates)
+        {
+            subset[state / 64] |= uint64_t(1) << (state % 64);
+        }
+        AddEpsilonClosure(nfa, subset, stack);
+        subsets.Insert(subset.data());
+
+        for (uint32_t current = 0; current < subsets.GetSize(); ++current)
+        {
+            const uint64_t* bits = subsets.Get(current);
+            bool isFinal = false;
+            for (size_t word = 0; word < words; ++word)
+            {
+                isFinal = isFinal || (bits[word] & finalStates[word]) != 0;
+            }
+            dfa.finalStates.push_back(isFinal);
+
+            for (auto input: sourceInputs)
+            {
+                // The arena may grow on insertion, so the current subset is looked up again.
+                bits = subsets.Get(current);
+                std::fill(subset.begin(), subset.end(), 0);
+                bool isEmpty = true;
+
+                for (size_t word = 0; word < words; ++word)
+                {
+                    for (uint64_t rest = bits[word]; rest != 0; rest &= rest - 1)
+                    {
+                        auto state = static_cast<uint32_t>(word * 64 + std::countr_zero(rest));
+                        auto [first, last] = nfa.GetNextStates(state, input);
+                        for (auto it = first; it != last; ++it)
+                        {
+                            subset[*it / 64] |= uint64_t(1) << (*it % 64);
+                            isEmpty = false;
+                        }
+                    }
+                }
+
+                if (!isEmpty)
+                {
+                    AddEpsilonClosure(nfa, subset, stack);
+                    dfa.targets.push_back(subsets.Insert(subset.data()).first);
+                }
+                dfa.offsets.push_back(static_cast<uint32_t>(dfa.targets.size()));
+            }
+        }
+
+        dfa.statesCount = subsets.GetSize();
+
+        return dfa;
+    }
+
+    static void AddEpsilonClosure(const Nfa& nfa, std::vector<uint64_t>& subset, std::vector<uint32_t>& stack)
+    {
+        if (nfa.epsilonInput == NO_INPUT)
+        {
+            return;
+        }
+
+        stack.clear();
+        for (size_t word = 0; word < subset.size(); ++word)
+        {
+            for (uint64_t rest = subset[word]; rest != 0; rest &= rest - 1)
+            {
+                stack.push_back(static_cast<uint32_t>(word * 64 + std::countr_zero(rest)));
+            }
+        }
+
+        while (!stack.empty())
+        {
+            uint32_t state = stack.back();
+            stack.pop_back();
+
+            auto [first, last] = nfa.GetNextStates(state, nfa.epsilonInput);
+            for (auto it = first; it != last; ++it)
+            {
+                uint64_t bit = uint64_t(1) << (*it % 64);
+                if ((subset[*it / 64] & bit) == 0)
+                {
+                    subset[*it / 64] |= bit;
+                    stack.push_back(*it);
+                }
+            }
+        }
+    }
+
+    static MooreAutomata ToMooreAutomata(const Nfa& dfa)
+    {
+        std::vector<std::string> names;
+        names.reserve(dfa.statesCount);
+        for (size_t state = 0; state < dfa.statesCount; ++state)
+        {
+            names.push_back(NEW_STATE_CHAR + std::to_string(state));
+        }
+
+        std::set<std::string> finalStates;
+        Transitions transitions;
+
+        for (uint32_t state = 0; state < dfa.statesCount; ++state)
+        {
+            if (dfa.finalStates[state])
+            {
+                finalStates.insert(names[state]);
+            }
+
+            auto& stateTransitions = transitions[names[state]];
+            for (uint32_t input = 0; input < dfa.inputs.size(); ++input)
+            {
+                auto [first, last] = dfa.GetNextStates(state, input);
+                if (first != last)
+                {
+                    stateTransitions.emplace(dfa.inputs[input], Transition(dfa.inputs[input], names[*first]));
+                }
+            }
+        }
+
+        return {std::set<std::string>(dfa.inputs.begin(), dfa.inputs.end()),
+                std::set<std::string>(names.begin(), names.end()), transitions, names.front(), finalStates};
+    }
+};
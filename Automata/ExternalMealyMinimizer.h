@@ -0,0 +1,626 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ExternalSorter.h"
+#include "MappedFile.h"
+#include "OutputTable.h"
+
+// Minimizes Mealy tables that do not fit into memory. The table is interned into
+// memory-mapped files (next state indexes and dictionary-encoded outputs), and the
+// partition is refined one input at a time with sequential sort-and-scan passes,
+// so apart from the sort runs only a reachability bitmap stays in RAM.
+// Produces the same table as MealyAutomata::Minimize.
+class ExternalMealyMinimizer
+{
+public:
+    static constexpr size_t DEFAULT_RAM_BUDGET_MB = 1024;
+    static constexpr size_t MIN_RAM_BUDGET_MB = 1;
+
+    ExternalMealyMinimizer(size_t ramBudgetBytes, const std::filesystem::path& tempDirectory)
+        : m_ramBudget(ramBudgetBytes)
+        , m_directory(tempDirectory / ("mim_" + std::to_string(std::random_device()())))
+    {
+    }
+
+    ExternalMealyMinimizer(const ExternalMealyMinimizer&) = delete;
+    ExternalMealyMinimizer& operator=(const ExternalMealyMinimizer&) = delete;
+
+    ~ExternalMealyMinimizer()
+    {
+        std::error_code error;
+        std::filesystem::remove_all(m_directory, error);
+    }
+
+    void Minimize(const std::string& inputFile, const std::string& outputFile)
+    {
+        std::filesystem::create_directories(m_directory);
+
+        ReadTable(inputFile);
+        MarkReachableStates();
+        BuildPredecessors();
+        RefinePartition();
+        PrintMinimized(outputFile);
+    }
+
+private:
+    static constexpr uint32_t UNREACHABLE_CLASS = std::numeric_limits<uint32_t>::max();
+
+    // Names are spilled to a bytes file, records keep their place there so that names
+    // with the same hash can be told apart.
+    struct NameRef
+    {
+        uint64_t offset;
+        uint64_t length;
+    };
+
+    struct NameRecord
+    {
+        uint64_t hash;
+        uint64_t state;
+        NameRef name;
+    };
+
+    struct CellRecord
+    {
+        uint64_t hash;
+        uint64_t cell;
+        NameRef name;
+    };
+
+    struct CellTarget
+    {
+        uint64_t cell;
+        uint64_t state;
+    };
+
+    struct StateValue
+    {
+        uint32_t state;
+        uint32_t value;
+    };
+
+    struct KeyRecord
+    {
+        uint32_t block;
+        uint32_t value;
+        uint32_t state;
+    };
+
+    struct ByHash
+    {
+        bool operator()(const NameRecord& left, const NameRecord& right) const
+        {
+            return left.hash < right.hash;
+        }
+
+        bool operator()(const CellRecord& left, const CellRecord& right) const
+        {
+            return left.hash < right.hash;
+        }
+    };
+
+    struct ByCell
+    {
+        bool operator()(const CellTarget& left, const CellTarget& right) const
+        {
+            return left.cell < right.cell;
+        }
+    };
+
+    struct ByState
+    {
+        bool operator()(const StateValue& left, const StateValue& right) const
+        {
+            return left.state < right.state;
+        }
+    };
+
+    struct ByValue
+    {
+        bool operator()(const StateValue& left, const StateValue& right) const
+        {
+            return left.value < right.value || (left.value == right.value && left.state < right.state);
+        }
+    };
+
+    struct ByKey
+    {
+        bool operator()(const KeyRecord& left, const KeyRecord& right) const
+        {
+            return left.block < right.block || (left.block == right.block && left.value < right.value);
+        }
+    };
+
+    // Reads ';' separated cells straight from the stream buffer, lines may be arbitrarily long.
+    class CellReader
+    {
+    public:
+        explicit CellReader(std::istream& stream)
+            : m_buffer(stream.rdbuf())
+        {
+        }
+
+        bool ReadCell(std::string& cell, bool& isLineEnd)
+        {
+            cell.clear();
+            int c = m_buffer->sbumpc();
+            if (c == std::char_traits<char>::eof())
+            {
+                return false;
+            }
+
+            while (c != std::char_traits<char>::eof() && c != ';' && c != '\n')
+            {
+                if (c != '\r')
+                {
+                    cell.push_back(static_cast<char>(c));
+                }
+                c = m_buffer->sbumpc();
+            }
+
+            isLineEnd = c != ';';
+            return true;
+        }
+
+    private:
+        std::streambuf* m_buffer;
+    };
+
+    static uint64_t HashName(const std::string& name)
+    {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (char c: name)
+        {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001B3ull;
+        }
+
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 33;
+
+        return hash;
+    }
+
+    // Spills the name and returns its place in the bytes file.
+    static NameRef WriteName(RecordWriter<char>& names, uint64_t& offset, const std::string_view& name)
+    {
+        names.Write(name.data(), name.size());
+        NameRef ref = {offset, name.size()};
+        offset += name.size();
+
+        return ref;
+    }
+
+    static std::string_view GetName(const MappedFile& names, const NameRef& ref)
+    {
+        return {names.GetData<char>() + ref.offset, ref.length};
+    }
+
+    [[nodiscard]] std::filesystem::path GetPath(const std::string& name) const
+    {
+        return m_directory / name;
+    }
+
+    template <typename Record, typename Less>
+    void SortFile(const std::string& input, const std::string& output) const
+    {
+        ExternalSorter<Record, Less>(m_ramBudget).Sort(GetPath(input), GetPath(output));
+    }
+
+    void ReadTable(const std::string& inputFile)
+    {
+        std::ifstream file(inputFile, std::ios::binary);
+        if (!file.is_open())
+        {
+            throw std::invalid_argument("Could not open input file " + inputFile);
+        }
+
+        CellReader reader(file);
+        std::string cell;
+        bool isLineEnd = false;
+
+        RecordWriter<NameRecord> names(GetPath("names"));
+        RecordWriter<char> nameBytes(GetPath("name_bytes"));
+        uint64_t nameBytesCount = 0;
+        reader.ReadCell(cell, isLineEnd);
+        while (!isLineEnd && reader.ReadCell(cell, isLineEnd))
+        {
+            if (m_statesCount == 0)
+            {
+                m_stateChar = cell.empty() ? 'q' : cell.front();
+            }
+            names.Write({HashName(cell), m_statesCount++, WriteName(nameBytes, nameBytesCount, cell)});
+        }
+        names.Close();
+        nameBytes.Close();
+
+        if (m_statesCount == 0 || m_statesCount >= UNREACHABLE_CLASS)
+        {
+            throw std::invalid_argument("Unsupported states count in " + inputFile);
+        }
+
+        RecordWriter<CellRecord> cells(GetPath("cells"));
+        RecordWriter<char> targetBytes(GetPath("target_bytes"));
+        RecordWriter<uint16_t> outputs(GetPath("outputs"));
+        uint64_t targetBytesCount = 0;
+        uint64_t cellIndex = 0;
+
+        while (reader.ReadCell(cell, isLineEnd))
+        {
+            if (isLineEnd && cell.empty())
+            {
+                continue;
+            }
+            m_inputSymbols.push_back(cell);
+
+            uint64_t rowCells = 0;
+            while (!isLineEnd && reader.ReadCell(cell, isLineEnd))
+            {
+                auto pos = cell.find('/');
+                if (pos == std::string::npos)
+                {
+                    throw std::invalid_argument("Missing output in cell " + cell);
+                }
+
+                std::string target = cell.substr(0, pos);
+                cells.Write({HashName(target), cellIndex++, WriteName(targetBytes, targetBytesCount, target)});
+                outputs.Write(m_outputs.Encode(cell.substr(pos + 1)));
+                ++rowCells;
+            }
+
+            if (rowCells != m_statesCount)
+            {
+                throw std::invalid_argument("Row " + m_inputSymbols.back() + " does not match the states count");
+            }
+        }
+        cells.Close();
+        targetBytes.Close();
+        outputs.Close();
+
+        ResolveTargets();
+    }
+
+    // Joins the target names of all cells with the header by name hash and writes the
+    // dense input-major table of next state indexes. Names with equal hashes are compared
+    // byte by byte, so a collision never merges two different names.
+    void ResolveTargets()
+    {
+        SortFile<NameRecord, ByHash>("names", "names.sorted");
+        SortFile<CellRecord, ByHash>("cells", "cells.sorted");
+        {
+            MappedFile namesFile = MappedFile::Open(GetPath("names.sorted"));
+            MappedFile cellsFile = MappedFile::Open(GetPath("cells.sorted"));
+            MappedFile nameBytes = MappedFile::Open(GetPath("name_bytes"));
+            MappedFile targetBytes = MappedFile::Open(GetPath("target_bytes"));
+            const NameRecord* names = namesFile.GetData<NameRecord>();
+            const CellRecord* cells = cellsFile.GetData<CellRecord>();
+            size_t namesCount = namesFile.GetCount<NameRecord>();
+            size_t cellsCount = cellsFile.GetCount<CellRecord>();
+
+            for (size_t name = 0; name < namesCount; ++name)
+            {
+                for (size_t other = name + 1; other < namesCount && names[other].hash == names[name].hash; ++other)
+                {
+                    if (GetName(nameBytes, names[name].name) == GetName(nameBytes, names[other].name))
+                    {
+                        throw std::invalid_argument("Duplicate state name in header");
+                    }
+                }
+            }
+
+            // Targets come out in hash order and are sorted back by cell.
+            RecordWriter<CellTarget> targets(GetPath("targets"));
+            size_t name = 0;
+            for (size_t cell = 0; cell < cellsCount; ++cell)
+            {
+                while (name < namesCount && names[name].hash < cells[cell].hash)
+                {
+                    ++name;
+                }
+
+                size_t match = name;
+                std::string_view target = GetName(targetBytes, cells[cell].name);
+                while (match < namesCount && names[match].hash == cells[cell].hash &&
+                       GetName(nameBytes, names[match].name) != target)
+                {
+                    ++match;
+                }
+
+                if (match == namesCount || names[match].hash != cells[cell].hash)
+                {
+                    throw std::invalid_argument("Unknown state in transition");
+                }
+
+                targets.Write({cells[cell].cell, names[match].state});
+            }
+            targets.Close();
+        }
+        std::filesystem::remove(GetPath("names.sorted"));
+        std::filesystem::remove(GetPath("cells.sorted"));
+        std::filesystem::remove(GetPath("name_bytes"));
+        std::filesystem::remove(GetPath("target_bytes"));
+
+        SortFile<CellTarget, ByCell>("targets", "targets.sorted");
+        {
+            MappedFile targetsFile = MappedFile::Open(GetPath("targets.sorted"));
+            const CellTarget* targets = targetsFile.GetData<CellTarget>();
+            RecordWriter<uint32_t> next(GetPath("next"));
+
+            for (size_t cell = 0; cell < targetsFile.GetCount<CellTarget>(); ++cell)
+            {
+                next.Write(static_cast<uint32_t>(targets[cell].state));
+            }
+            next.Close();
+        }
+        std::filesystem::remove(GetPath("targets.sorted"));
+    }
+
+    void MarkReachableStates()
+    {
+        MappedFile nextFile = MappedFile::Open(GetPath("next"));
+        const uint32_t* next = nextFile.GetData<uint32_t>();
+        MappedFile queueFile = MappedFile::Create(GetPath("queue"), m_statesCount * sizeof(uint32_t));
+        uint32_t* queue = queueFile.GetData<uint32_t>();
+
+        m_reachable.assign((m_statesCount + 63) / 64, 0);
+        m_reachable[0] = 1;
+        queue[0] = 0;
+        size_t queueEnd = 1;
+
+        for (size_t head = 0; head < queueEnd; ++head)
+        {
+            for (size_t input = 0; input < m_inputSymbols.size(); ++input)
+            {
+                uint32_t target = next[input * m_statesCount + queue[head]];
+                if (!IsReachable(target))
+                {
+                    m_reachable[target / 64] |= uint64_t(1) << (target % 64);
+                    queue[queueEnd++] = target;
+                }
+            }
+        }
+
+        m_reachableCount = queueEnd;
+    }
+
+    [[nodiscard]] bool IsReachable(uint64_t state) const
+    {
+        return (m_reachable[state / 64] >> (state % 64)) & 1;
+    }
+
+    // For every input, the (source, target) edges of reachable states sorted by target,
+    // so that the block of every target can be read with one sequential pass over the blocks.
+    void BuildPredecessors() const
+    {
+        MappedFile nextFile = MappedFile::Open(GetPath("next"));
+        const uint32_t* next = nextFile.GetData<uint32_t>();
+
+        for (size_t input = 0; input < m_inputSymbols.size(); ++input)
+        {
+            std::string name = "edges" + std::to_string(input);
+            RecordWriter<StateValue> edges(GetPath(name));
+
+            for (uint32_t state = 0; state < m_statesCount; ++state)
+            {
+                if (IsReachable(state))
+                {
+                    edges.Write({state, next[input * m_statesCount + state]});
+                }
+            }
+            edges.Close();
+
+            SortFile<StateValue, ByValue>(name, name + ".sorted");
+        }
+    }
+
+    void RefinePartition()
+    {
+        {
+            MappedFile blocksFile = MappedFile::Create(GetPath("blocks"), m_statesCount * sizeof(uint32_t));
+            uint32_t* blocks = blocksFile.GetData<uint32_t>();
+            for (uint32_t state = 0; state < m_statesCount; ++state)
+            {
+                blocks[state] = IsReachable(state) ? 0 : UNREACHABLE_CLASS;
+            }
+        }
+        m_blocksCount = 1;
+
+        for (size_t input = 0; input < m_inputSymbols.size(); ++input)
+        {
+            WriteOutputKeys(input);
+            RankKeys();
+        }
+
+        while (m_blocksCount < m_reachableCount)
+        {
+            size_t blocksCount = m_blocksCount;
+
+            for (size_t input = 0; input < m_inputSymbols.size(); ++input)
+            {
+                WriteSuccessorBlocks(input);
+                WriteSuccessorKeys();
+                RankKeys();
+            }
+
+            // Blocks are only ever split, so the partition is stable once their count stops growing.
+            if (m_blocksCount == blocksCount)
+            {
+                break;
+            }
+        }
+    }
+
+    void WriteOutputKeys(size_t input) const
+    {
+        MappedFile blocksFile = MappedFile::Open(GetPath("blocks"));
+        MappedFile outputsFile = MappedFile::Open(GetPath("outputs"));
+        const uint32_t* blocks = blocksFile.GetData<uint32_t>();
+        const uint16_t* outputs = outputsFile.GetData<uint16_t>() + input * m_statesCount;
+
+        RecordWriter<KeyRecord> keys(GetPath("keys"));
+        for (uint32_t state = 0; state < m_statesCount; ++state)
+        {
+            if (blocks[state] != UNREACHABLE_CLASS)
+            {
+                keys.Write({blocks[state], outputs[state], state});
+            }
+        }
+        keys.Close();
+    }
+
+    // Reads the block of every target in target order and sorts the result back by source.
+    void WriteSuccessorBlocks(size_t input) const
+    {
+        {
+            MappedFile blocksFile = MappedFile::Open(GetPath("blocks"));
+            MappedFile edgesFile = MappedFile::Open(GetPath("edges" + std::to_string(input) + ".sorted"));
+            const uint32_t* blocks = blocksFile.GetData<uint32_t>();
+            const StateValue* edges = edgesFile.GetData<StateValue>();
+
+            RecordWriter<StateValue> successors(GetPath("successors"));
+            for (size_t edge = 0; edge < edgesFile.GetCount<StateValue>(); ++edge)
+            {
+                successors.Write({edges[edge].state, blocks[edges[edge].value]});
+            }
+            successors.Close();
+        }
+
+        SortFile<StateValue, ByState>("successors", "successors.sorted");
+    }
+
+    void WriteSuccessorKeys() const
+    {
+        {
+            MappedFile blocksFile = MappedFile::Open(GetPath("blocks"));
+            MappedFile successorsFile = MappedFile::Open(GetPath("successors.sorted"));
+            const uint32_t* blocks = blocksFile.GetData<uint32_t>();
+            const StateValue* successors = successorsFile.GetData<StateValue>();
+
+            RecordWriter<KeyRecord> keys(GetPath("keys"));
+            for (size_t index = 0; index < successorsFile.GetCount<StateValue>(); ++index)
+            {
+                uint32_t state = successors[index].state;
+                keys.Write({blocks[state], successors[index].value, state});
+            }
+            keys.Close();
+        }
+        std::filesystem::remove(GetPath("successors.sorted"));
+    }
+
+    // Numbers the distinct (block, value) keys and stores the numbers as the new blocks.
+    void RankKeys()
+    {
+        SortFile<KeyRecord, ByKey>("keys", "keys.sorted");
+        {
+            MappedFile keysFile = MappedFile::Open(GetPath("keys.sorted"));
+            const KeyRecord* keys = keysFile.GetData<KeyRecord>();
+            size_t keysCount = keysFile.GetCount<KeyRecord>();
+
+            RecordWriter<StateValue> ranks(GetPath("ranks"));
+            uint32_t rank = 0;
+            for (size_t index = 0; index < keysCount; ++index)
+            {
+                if (index > 0 && ByKey()(keys[index - 1], keys[index]))
+                {
+                    ++rank;
+                }
+                ranks.Write({keys[index].state, rank});
+            }
+            ranks.Close();
+            m_blocksCount = keysCount == 0 ? 0 : rank + 1;
+        }
+        std::filesystem::remove(GetPath("keys.sorted"));
+
+        SortFile<StateValue, ByState>("ranks", "ranks.sorted");
+        {
+            MappedFile blocksFile = MappedFile::Open(GetPath("blocks"));
+            MappedFile newBlocksFile = MappedFile::Create(GetPath("blocks.new"), m_statesCount * sizeof(uint32_t));
+            MappedFile ranksFile = MappedFile::Open(GetPath("ranks.sorted"));
+            const uint32_t* blocks = blocksFile.GetData<uint32_t>();
+            uint32_t* newBlocks = newBlocksFile.GetData<uint32_t>();
+            const StateValue* ranks = ranksFile.GetData<StateValue>();
+
+            for (uint32_t state = 0, index = 0; state < m_statesCount; ++state)
+            {
+                newBlocks[state] = blocks[state] == UNREACHABLE_CLASS ? UNREACHABLE_CLASS : ranks[index++].value;
+            }
+        }
+        std::filesystem::remove(GetPath("ranks.sorted"));
+        std::filesystem::rename(GetPath("blocks.new"), GetPath("blocks"));
+    }
+
+    // Minimized states are named after the first char of the first state and numbered in the order
+    // their first member appears, each one takes the transitions of that first member.
+    void PrintMinimized(const std::string& outputFile) const
+    {
+        MappedFile nextFile = MappedFile::Open(GetPath("next"));
+        MappedFile outputsFile = MappedFile::Open(GetPath("outputs"));
+        MappedFile blocksFile = MappedFile::Open(GetPath("blocks"));
+        MappedFile namesFile = MappedFile::Create(GetPath("block_names"), m_blocksCount * sizeof(uint32_t));
+        MappedFile representativesFile = MappedFile::Create(GetPath("representatives"), m_blocksCount * sizeof(uint32_t));
+        const uint32_t* next = nextFile.GetData<uint32_t>();
+        const uint16_t* outputs = outputsFile.GetData<uint16_t>();
+        const uint32_t* blocks = blocksFile.GetData<uint32_t>();
+        uint32_t* names = namesFile.GetData<uint32_t>();
+        uint32_t* representatives = representativesFile.GetData<uint32_t>();
+
+        std::fill(names, names + m_blocksCount, UNREACHABLE_CLASS);
+        uint32_t namesCount = 0;
+        for (uint32_t state = 0; state < m_statesCount; ++state)
+        {
+            if (blocks[state] != UNREACHABLE_CLASS && names[blocks[state]] == UNREACHABLE_CLASS)
+            {
+                representatives[namesCount] = state;
+                names[blocks[state]] = namesCount++;
+            }
+        }
+
+        std::ofstream file(outputFile);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Could not open output file " + outputFile);
+        }
+
+        for (uint32_t name = 0; name < namesCount; ++name)
+        {
+            file << ";" << m_stateChar << name;
+        }
+        file << "\n";
+
+        for (size_t input = 0; input < m_inputSymbols.size(); ++input)
+        {
+            file << m_inputSymbols[input];
+            for (uint32_t name = 0; name < namesCount; ++name)
+            {
+                size_t cell = input * m_statesCount + representatives[name];
+                file << ";" << m_stateChar << names[blocks[next[cell]]] << "/" << m_outputs.GetSymbol(outputs[cell]);
+            }
+            file << "\n";
+        }
+
+        if (!file)
+        {
+            throw std::runtime_error("Could not write to file " + outputFile);
+        }
+    }
+
+    size_t m_ramBudget;
+    std::filesystem::path m_directory;
+
+    uint64_t m_statesCount = 0;
+    char m_stateChar = 'q';
+    std::vector<std::string> m_inputSymbols;
+    OutputDictionary m_outputs;
+
+    std::vector<uint64_t> m_reachable;
+    size_t m_reachableCount = 0;
+    size_t m_blocksCount = 0;
+};
@@ -0,0 +1,180 @@
+#pragma once
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "MappedFile.h"
+
+// Sequential writer of fixed-size records.
+template <typename Record>
+class RecordWriter
+{
+    static_assert(std::is_trivially_copyable_v<Record>);
+
+public:
+    explicit RecordWriter(const std::filesystem::path& path)
+        : m_file(path, std::ios::binary | std::ios::trunc)
+    {
+        if (!m_file.is_open())
+        {
+            throw std::runtime_error("Could not open temporary file " + path.string());
+        }
+    }
+
+    void Write(const Record& record)
+    {
+        m_file.write(reinterpret_cast<const char*>(&record), sizeof(Record));
+    }
+
+    void Write(const Record* records, size_t count)
+    {
+        m_file.write(reinterpret_cast<const char*>(records), static_cast<std::streamsize>(count * sizeof(Record)));
+    }
+
+    void Close()
+    {
+        m_file.close();
+        if (m_file.fail())
+        {
+            throw std::runtime_error("Could not write temporary file");
+        }
+    }
+
+private:
+    std::ofstream m_file;
+};
+
+// Sorts a file of fixed-size records with a bounded amount of memory: runs that fit
+// into the budget are sorted in memory and written out, then merged in k-way passes of
+// at most MAX_MERGE_WAYS runs, so the open mappings stay bounded however many runs there are.
+template <typename Record, typename Less>
+class ExternalSorter
+{
+    static_assert(std::is_trivially_copyable_v<Record>);
+
+public:
+    static constexpr size_t MAX_MERGE_WAYS = 64;
+
+    ExternalSorter(size_t budgetBytes, Less less = Less())
+        : m_runRecords(std::max<size_t>(budgetBytes / sizeof(Record), 1))
+        , m_less(less)
+    {
+    }
+
+    // The input file is removed once it has been consumed.
+    void Sort(const std::filesystem::path& input, const std::filesystem::path& output) const
+    {
+        std::vector<std::filesystem::path> runs;
+        {
+            MappedFile source = MappedFile::Open(input);
+            const Record* records = source.GetData<Record>();
+            size_t count = source.GetCount<Record>();
+            std::vector<Record> run;
+
+            for (size_t first = 0; first < count || runs.empty(); first += m_runRecords)
+            {
+                size_t last = std::min(count, first + m_runRecords);
+                run.assign(records + first, records + last);
+                std::sort(run.begin(), run.end(), m_less);
+
+                runs.push_back(output.string() + ".run" + std::to_string(runs.size()));
+                WriteRun(runs.back(), run);
+            }
+        }
+        std::filesystem::remove(input);
+
+        for (size_t pass = 0; runs.size() > 1; ++pass)
+        {
+            std::vector<std::filesystem::path> mergedRuns;
+            for (size_t first = 0; first < runs.size(); first += MAX_MERGE_WAYS)
+            {
+                std::vector<std::filesystem::path> group(runs.begin() + first,
+                                                         runs.begin() + std::min(runs.size(), first + MAX_MERGE_WAYS));
+                if (group.size() == 1)
+                {
+                    mergedRuns.push_back(group.front());
+                    continue;
+                }
+
+                mergedRuns.push_back(output.string() + ".merge" + std::to_string(pass) + "_" +
+                                     std::to_string(mergedRuns.size()));
+                Merge(group, mergedRuns.back());
+                for (auto& run: group)
+                {
+                    std::filesystem::remove(run);
+                }
+            }
+            runs = std::move(mergedRuns);
+        }
+
+        std::filesystem::rename(runs.front(), output);
+    }
+
+private:
+    struct RunCursor
+    {
+        MappedFile file;
+        const Record* current;
+        const Record* end;
+    };
+
+    static void WriteRun(const std::filesystem::path& path, const std::vector<Record>& run)
+    {
+        RecordWriter<Record> writer(path);
+        for (auto& record: run)
+        {
+            writer.Write(record);
+        }
+        writer.Close();
+    }
+
+    // Runs are read through their mappings, so only the pages in use stay resident.
+    void Merge(const std::vector<std::filesystem::path>& runs, const std::filesystem::path& output) const
+    {
+        std::vector<RunCursor> cursors;
+        cursors.reserve(runs.size());
+        for (auto& run: runs)
+        {
+            MappedFile file = MappedFile::Open(run);
+            const Record* begin = file.GetData<Record>();
+            size_t count = file.GetCount<Record>();
+            cursors.push_back({std::move(file), begin, begin + count});
+        }
+
+        auto isGreater = [&](size_t left, size_t right) {
+            return m_less(*cursors[right].current, *cursors[left].current);
+        };
+        std::priority_queue<size_t, std::vector<size_t>, decltype(isGreater)> heap(isGreater);
+
+        for (size_t run = 0; run < cursors.size(); ++run)
+        {
+            if (cursors[run].current != cursors[run].end)
+            {
+                heap.push(run);
+            }
+        }
+
+        RecordWriter<Record> writer(output);
+        while (!heap.empty())
+        {
+            size_t run = heap.top();
+            heap.pop();
+
+            writer.Write(*cursors[run].current++);
+            if (cursors[run].current != cursors[run].end)
+            {
+                heap.push(run);
+            }
+        }
+        writer.Close();
+    }
+
+    size_t m_runRecords;
+    Less m_less;
+};
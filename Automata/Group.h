@@ -24,7 +24,7 @@ public:
         }
     }
 
-    [[nodiscard]] std::set<std::string> GetStates() const
+    [[nodiscard]] const std::set<std::string>& GetStates() const
     {
         return m_states;
     }
@@ -34,7 +34,7 @@ public:
         return m_states.size();
     }
 
-    std::string GetMainState()
+    [[nodiscard]] std::string GetMainState() const
     {
         for (auto& state : m_states)
         {
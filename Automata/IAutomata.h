@@ -6,10 +6,35 @@
 class IAutomata
 {
 public:
-    virtual void PrintToFile(const std::string& filename) = 0;
-    virtual void ReadFromFile(const std::string& filename) = 0;
+    virtual void PrintToStream(std::ostream& stream) = 0;
+    virtual void ReadFromStream(std::istream& stream) = 0;
     virtual void Minimize() = 0;
+    [[nodiscard]] virtual size_t GetStatesCount() const = 0;
+    // Whether the last Minimize found nothing to remove or merge.
+    [[nodiscard]] virtual bool IsAlreadyMinimal() const = 0;
     virtual ~IAutomata() = default;
+
+    virtual void PrintToFile(const std::string& filename)
+    {
+        std::ofstream file(filename);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Could not open output file " + filename);
+        }
+
+        PrintToStream(file);
+    }
+
+    virtual void ReadFromFile(const std::string& filename)
+    {
+        std::ifstream file(filename);
+        if (!file.is_open())
+        {
+            throw std::invalid_argument("Could not open input file " + filename);
+        }
+
+        ReadFromStream(file);
+    }
 };
 
 #endif //LAB1_IAUTOMATA_H
@@ -0,0 +1,162 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "MooreAutomata.h"
+
+// Integer view of a MooreAutomata: states and inputs are numbered in the order
+// of the source sets, transitions are stored in one flat (state, input) table.
+class IndexedAutomata
+{
+public:
+    static constexpr uint32_t NO_STATE = std::numeric_limits<uint32_t>::max();
+    static constexpr uint32_t NO_INPUT = std::numeric_limits<uint32_t>::max();
+
+    explicit IndexedAutomata(const MooreAutomata& automata)
+    {
+        std::map<std::string, uint32_t> stateIndexes;
+        for (auto& state: automata.GetStates())
+        {
+            stateIndexes.emplace(state, static_cast<uint32_t>(m_stateNames.size()));
+            m_stateNames.push_back(state);
+        }
+
+        for (auto& input: automata.GetInputs())
+        {
+            if (input == E_CLOSE)
+            {
+                m_epsilonInput = static_cast<uint32_t>(m_inputs.size());
+            }
+            m_inputIndexes.emplace(input, static_cast<uint32_t>(m_inputs.size()));
+            m_inputs.push_back(input);
+        }
+
+        m_startState = GetStateIndex(stateIndexes, automata.GetStartState());
+
+        m_finalStates.assign(m_stateNames.size(), false);
+        for (auto& state: automata.GetFinalStates())
+        {
+            m_finalStates[GetStateIndex(stateIndexes, state)] = true;
+        }
+
+        auto& transitions = automata.GetTransitions();
+        m_offsets.reserve(m_stateNames.size() * m_inputs.size() + 1);
+        m_offsets.push_back(0);
+
+        for (auto& state: m_stateNames)
+        {
+            auto stateTransitions = transitions.find(state);
+
+            for (auto& input: m_inputs)
+            {
+                if (stateTransitions != transitions.end() && stateTransitions->second.contains(input))
+                {
+                    for (auto& nextState: stateTransitions->second.at(input).GetStates())
+                    {
+                        m_targets.push_back(GetStateIndex(stateIndexes, nextState));
+                    }
+                }
+                m_offsets.push_back(static_cast<uint32_t>(m_targets.size()));
+            }
+        }
+    }
+
+    [[nodiscard]] size_t GetStatesCount() const
+    {
+        return m_stateNames.size();
+    }
+
+    [[nodiscard]] size_t GetInputsCount() const
+    {
+        return m_inputs.size();
+    }
+
+    [[nodiscard]] uint32_t GetStartState() const
+    {
+        return m_startState;
+    }
+
+    [[nodiscard]] bool IsFinalState(uint32_t state) const
+    {
+        return m_finalStates[state];
+    }
+
+    [[nodiscard]] const std::string& GetStateName(uint32_t state) const
+    {
+        return m_stateNames[state];
+    }
+
+    [[nodiscard]] const std::vector<std::string>& GetInputs() const
+    {
+        return m_inputs;
+    }
+
+    [[nodiscard]] uint32_t GetInputIndex(const std::string& input) const
+    {
+        auto it = m_inputIndexes.find(input);
+        return it == m_inputIndexes.end() ? NO_INPUT : it->second;
+    }
+
+    [[nodiscard]] uint32_t GetEpsilonInput() const
+    {
+        return m_epsilonInput;
+    }
+
+    [[nodiscard]] std::span<const uint32_t> GetNextStates(uint32_t state, uint32_t input) const
+    {
+        size_t cell = state * m_inputs.size() + input;
+        return {m_targets.data() + m_offsets[cell], m_targets.data() + m_offsets[cell + 1]};
+    }
+
+    // Returns NO_STATE when the transition is missing.
+    [[nodiscard]] uint32_t GetNextState(uint32_t state, uint32_t input) const
+    {
+        auto nextStates = GetNextStates(state, input);
+        return nextStates.empty() ? NO_STATE : nextStates.front();
+    }
+
+    [[nodiscard]] bool IsDeterministic() const
+    {
+        if (m_epsilonInput != NO_INPUT)
+        {
+            return false;
+        }
+
+        for (size_t cell = 0; cell + 1 < m_offsets.size(); ++cell)
+        {
+            if (m_offsets[cell + 1] - m_offsets[cell] > 1)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+private:
+    static uint32_t GetStateIndex(const std::map<std::string, uint32_t>& stateIndexes, const std::string& state)
+    {
+        auto it = stateIndexes.find(state);
+        if (it == stateIndexes.end())
+        {
+            throw std::invalid_argument("Unknown state " + state);
+        }
+
+        return it->second;
+    }
+
+    std::vector<std::string> m_stateNames;
+    std::vector<std::string> m_inputs;
+    std::map<std::string, uint32_t> m_inputIndexes;
+    std::vector<bool> m_finalStates;
+    uint32_t m_startState = NO_STATE;
+    uint32_t m_epsilonInput = NO_INPUT;
+
+    std::vector<uint32_t> m_offsets;
+    std::vector<uint32_t> m_targets;
+};
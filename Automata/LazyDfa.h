@@ -0,0 +1,216 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "IndexedAutomata.h"
+
+// Runs an NFA by determinizing it on demand: every subset of NFA states met while
+// reading input becomes a cached DFA state with lazily filled transitions. When the
+// cache reaches its limit it is flushed and rebuilt from the current position.
+class LazyDfa
+{
+public:
+    static constexpr size_t DEFAULT_CACHE_STATES = 4096;
+
+    explicit LazyDfa(const IndexedAutomata& nfa, size_t maxCachedStates = DEFAULT_CACHE_STATES)
+        : m_nfa(nfa)
+        , m_maxCachedStates(std::max<size_t>(maxCachedStates, 1))
+        , m_marks(nfa.GetStatesCount(), 0)
+    {
+        m_startSubset.push_back(nfa.GetStartState());
+        CloseOverEpsilon(m_startSubset);
+    }
+
+    bool Accepts(const std::vector<std::string>& word)
+    {
+        uint32_t state = GetStartState();
+
+        for (auto& symbol: word)
+        {
+            uint32_t input = m_nfa.GetInputIndex(symbol);
+            if (input == IndexedAutomata::NO_INPUT || input == m_nfa.GetEpsilonInput())
+            {
+                return false;
+            }
+
+            state = Step(state, input);
+            if (state == DEAD_STATE)
+            {
+                return false;
+            }
+        }
+
+        return m_isFinal[state];
+    }
+
+    [[nodiscard]] size_t GetCachedStatesCount() const
+    {
+        return m_subsets.size();
+    }
+
+    [[nodiscard]] size_t GetCacheFlushesCount() const
+    {
+        return m_flushesCount;
+    }
+
+private:
+    static constexpr uint32_t UNKNOWN_STATE = std::numeric_limits<uint32_t>::max();
+    static constexpr uint32_t DEAD_STATE = UNKNOWN_STATE - 1;
+
+    struct SubsetHash
+    {
+        size_t operator()(const std::vector<uint32_t>& subset) const
+        {
+            size_t hash = subset.size();
+            for (uint32_t state: subset)
+            {
+                hash = (hash ^ state) * 0x100000001B3ull;
+            }
+
+            return hash;
+        }
+    };
+
+    uint32_t GetStartState()
+    {
+        if (m_startState == UNKNOWN_STATE)
+        {
+            m_startState = AddState(std::vector<uint32_t>(m_startSubset));
+        }
+
+        return m_startState;
+    }
+
+    uint32_t Step(uint32_t state, uint32_t input)
+    {
+        uint32_t& cached = m_next[state * m_nfa.GetInputsCount() + input];
+        if (cached != UNKNOWN_STATE)
+        {
+            return cached;
+        }
+
+        std::vector<uint32_t> subset;
+        NextGeneration();
+        for (uint32_t source: *m_subsets[state])
+        {
+            for (uint32_t target: m_nfa.GetNextStates(source, input))
+            {
+                if (m_marks[target] != m_generation)
+                {
+                    m_marks[target] = m_generation;
+                    subset.push_back(target);
+                }
+            }
+        }
+
+        if (subset.empty())
+        {
+            cached = DEAD_STATE;
+            return DEAD_STATE;
+        }
+
+        CloseOverEpsilon(subset);
+
+        auto it = m_stateIndexes.find(subset);
+        if (it != m_stateIndexes.end())
+        {
+            cached = it->second;
+            return it->second;
+        }
+
+        if (m_subsets.size() >= m_maxCachedStates)
+        {
+            // `cached` points into the table that is about to be dropped.
+            Flush();
+            return AddState(std::move(subset));
+        }
+
+        uint32_t nextState = AddState(std::move(subset));
+        m_next[state * m_nfa.GetInputsCount() + input] = nextState;
+
+        return nextState;
+    }
+
+    uint32_t AddState(std::vector<uint32_t>&& subset)
+    {
+        bool isFinal = std::any_of(subset.begin(), subset.end(), [this](uint32_t nfaState) {
+            return m_nfa.IsFinalState(nfaState);
+        });
+
+        auto index = static_cast<uint32_t>(m_subsets.size());
+        auto it = m_stateIndexes.emplace(std::move(subset), index).first;
+
+        m_subsets.push_back(&it->first);
+        m_isFinal.push_back(isFinal);
+        m_next.resize(m_next.size() + m_nfa.GetInputsCount(), UNKNOWN_STATE);
+
+        return index;
+    }
+
+    void Flush()
+    {
+        m_stateIndexes.clear();
+        m_subsets.clear();
+        m_isFinal.clear();
+        m_next.clear();
+        m_startState = UNKNOWN_STATE;
+        ++m_flushesCount;
+    }
+
+    void NextGeneration()
+    {
+        if (++m_generation == 0)
+        {
+            std::fill(m_marks.begin(), m_marks.end(), 0);
+            m_generation = 1;
+        }
+    }
+
+    // Extends the subset with its epsilon closure and sorts it into canonical form.
+    void CloseOverEpsilon(std::vector<uint32_t>& subset)
+    {
+        uint32_t epsilon = m_nfa.GetEpsilonInput();
+        if (epsilon != IndexedAutomata::NO_INPUT)
+        {
+            NextGeneration();
+            for (uint32_t state: subset)
+            {
+                m_marks[state] = m_generation;
+            }
+
+            for (size_t index = 0; index < subset.size(); ++index)
+            {
+                for (uint32_t target: m_nfa.GetNextStates(subset[index], epsilon))
+                {
+                    if (m_marks[target] != m_generation)
+                    {
+                        m_marks[target] = m_generation;
+                        subset.push_back(target);
+                    }
+                }
+            }
+        }
+
+        std::sort(subset.begin(), subset.end());
+    }
+
+    const IndexedAutomata& m_nfa;
+    size_t m_maxCachedStates;
+
+    std::vector<uint32_t> m_startSubset;
+    uint32_t m_startState = UNKNOWN_STATE;
+
+    std::unordered_map<std::vector<uint32_t>, uint32_t, SubsetHash> m_stateIndexes;
+    std::vector<const std::vector<uint32_t>*> m_subsets;
+    std::vector<bool> m_isFinal;
+    std::vector<uint32_t> m_next;
+    size_t m_flushesCount = 0;
+
+    std::vector<uint32_t> m_marks;
+    uint32_t m_generation = 0;
+};
@@ -0,0 +1,155 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Memory mapping of a whole file, either a new file of a fixed size mapped for
+// writing or an existing file mapped read-only. The mapping ends with the object.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+
+    static MappedFile Create(const std::filesystem::path& path, size_t size)
+    {
+        MappedFile file;
+        file.Map(path, size, true);
+        return file;
+    }
+
+    static MappedFile Open(const std::filesystem::path& path)
+    {
+        MappedFile file;
+        file.Map(path, std::filesystem::file_size(path), false);
+        return file;
+    }
+
+    MappedFile(MappedFile&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    MappedFile& operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Unmap();
+            std::swap(m_data, other.m_data);
+            std::swap(m_size, other.m_size);
+        }
+
+        return *this;
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile()
+    {
+        Unmap();
+    }
+
+    template <typename T>
+    [[nodiscard]] T* GetData() const
+    {
+        return static_cast<T*>(m_data);
+    }
+
+    template <typename T>
+    [[nodiscard]] size_t GetCount() const
+    {
+        return m_size / sizeof(T);
+    }
+
+private:
+    void Map(const std::filesystem::path& path, size_t size, bool isWritable)
+    {
+        m_size = size;
+        if (size == 0)
+        {
+            if (isWritable)
+            {
+                std::ofstream(path, std::ios::binary | std::ios::trunc);
+            }
+            return;
+        }
+
+#ifdef _WIN32
+        HANDLE file = CreateFileW(path.c_str(), isWritable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                                  FILE_SHARE_READ, nullptr, isWritable ? CREATE_ALWAYS : OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            throw std::runtime_error("Could not open mapped file " + path.string());
+        }
+
+        LARGE_INTEGER mappingSize;
+        mappingSize.QuadPart = static_cast<LONGLONG>(size);
+        HANDLE mapping = CreateFileMappingW(file, nullptr, isWritable ? PAGE_READWRITE : PAGE_READONLY,
+                                            mappingSize.HighPart, mappingSize.LowPart, nullptr);
+        CloseHandle(file);
+        if (mapping == nullptr)
+        {
+            throw std::runtime_error("Could not map file " + path.string());
+        }
+
+        m_data = MapViewOfFile(mapping, isWritable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+        CloseHandle(mapping);
+        if (m_data == nullptr)
+        {
+            throw std::runtime_error("Could not map file " + path.string());
+        }
+#else
+        int file = isWritable ? open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600) : open(path.c_str(), O_RDONLY);
+        if (file < 0 || (isWritable && ftruncate(file, static_cast<off_t>(size)) != 0))
+        {
+            if (file >= 0)
+            {
+                close(file);
+            }
+            throw std::runtime_error("Could not open mapped file " + path.string());
+        }
+
+        void* data = mmap(nullptr, size, isWritable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, file, 0);
+        close(file);
+        if (data == MAP_FAILED)
+        {
+            throw std::runtime_error("Could not map file " + path.string());
+        }
+
+        m_data = data;
+#endif
+    }
+
+    void Unmap()
+    {
+        if (m_data != nullptr)
+        {
+#ifdef _WIN32
+            UnmapViewOfFile(m_data);
+#else
+            munmap(m_data, m_size);
+#endif
+        }
+
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    void* m_data = nullptr;
+    size_t m_size = 0;
+};
@@ -2,6 +2,11 @@
 #define LAB1_MEALYAUTOMAT_H
 
 #include "IAutomata.h"
+#include "MinimizationReport.h"
+#include "OutputTable.h"
+#include "SignatureHasher.h"
+#include "SmallMinimizer.h"
+#include "StatePairMap.h"
 using namespace std;
 
 class MealyAutomata final : public IAutomata
@@ -9,15 +14,8 @@ class MealyAutomata final : public IAutomata
 public:
     MealyAutomata() = default;
 
-    void ReadFromFile(const std::string &filename) override
+    void ReadFromStream(std::istream &file) override
     {
-        ifstream file(filename);
-        if (!file.is_open())
-        {
-            cerr << "Error: Unable to open file " << filename << endl;
-            exit(1);
-        }
-
         string line;
 
         getline(file, line);
@@ -28,45 +26,89 @@ public:
         {
             m_states.push_back(cell);
         }
+        if (m_states.empty())
+        {
+            throw invalid_argument("No states in table header");
+        }
 
         while (getline(file, line))
         {
+            if (line.empty())
+            {
+                continue;
+            }
             stringstream row(line);
             string inputSymbol;
             getline(row, inputSymbol, ';');
             m_inputSymbols.push_back(inputSymbol);
 
-            vector<pair<string, string>> rowTransitions;
+            vector<string> rowNextStates;
             while (getline(row, cell, ';'))
             {
                 auto pos = cell.find('/');
-                string nextState = cell.substr(0, pos);
-                string outputSymbol = cell.substr(pos + 1);
-                rowTransitions.emplace_back(nextState, outputSymbol);
+                if (pos == string::npos)
+                {
+                    throw invalid_argument("Missing output in cell " + cell);
+                }
+                rowNextStates.push_back(cell.substr(0, pos));
+                m_outputs.Append(m_outputs.Encode(cell.substr(pos + 1)));
+            }
+            if (rowNextStates.size() != m_states.size())
+            {
+                throw invalid_argument("Row " + inputSymbol + " does not match the states count");
             }
-            m_transitions.push_back(rowTransitions);
+            m_nextStateNames.push_back(move(rowNextStates));
         }
-
-        file.close();
     }
 
+    // A machine that is already minimal (every state reachable, no two equivalent) is only renamed.
     void Minimize() override
     {
-        ClearUnreachableState();
+        m_isAlreadyMinimal = false;
+
+        // The small path keeps no split history, so a report always goes through refinement.
+        if (m_isSmallPathEnabled && !m_isReportEnabled &&
+            SmallMealyMinimizer::Fits(m_states.size(), m_inputSymbols.size()))
+        {
+            vector<uint32_t> nextStates = GetNextStateTable();
+            vector<int> partition = GetSmallPartition(nextStates);
+            m_isAlreadyMinimal = IsDiscretePartition(partition);
+            if (m_isAlreadyMinimal)
+            {
+                RenameStates(nextStates);
+                return;
+            }
+            BuildMinimizedAutomata(partition, nextStates);
+            return;
+        }
+
+        vector<string> originalStates = m_isReportEnabled ? m_states : vector<string>();
+        bool hasUnreachableStates = ClearUnreachableState();
+        vector<uint32_t> nextStates = GetNextStateTable();
         vector<int> partition = InitializePartition();
-        RefinePartition(partition);
 
-        BuildMinimizedAutomata(partition);
-    }
+        SplitTree splitTree;
+        if (m_isReportEnabled)
+        {
+            InitializeSplitTree(partition, splitTree);
+        }
+        RefinePartition(partition, nextStates, m_isReportEnabled ? &splitTree : nullptr);
+        m_isAlreadyMinimal = !hasUnreachableStates && IsDiscretePartition(partition);
 
-    void PrintToFile(const std::string &filename) override
-    {
-        ofstream file(filename);
-        if (!file.is_open()) {
-            cerr << "Error: Unable to write to file " << filename << endl;
-            exit(1);
+        if (m_isReportEnabled)
+        {
+            BuildReport(originalStates, partition, nextStates, splitTree);
         }
+        if (m_isAlreadyMinimal)
+        {
+            RenameStates(nextStates);
+            return;
+        }
+        BuildMinimizedAutomata(partition, nextStates);
+    }
 
+    void PrintToStream(std::ostream &file) override
+    {
         for (const string &state : m_states)
         {
             file << ";" << state;
@@ -76,151 +118,524 @@ public:
         for (size_t i = 0; i < m_inputSymbols.size(); ++i)
         {
             file << m_inputSymbols[i];
-            for (const auto &transition : m_transitions[i])
+            for (size_t j = 0; j < m_states.size(); ++j)
             {
-                file << ";" << transition.first << "/" << transition.second;
+                file << ";" << m_nextStateNames[i][j] << "/" << GetOutput(i, j);
             }
             file << endl;
         }
+    }
 
-        file.close();
+    void SetSmallPathEnabled(bool isEnabled)
+    {
+        m_isSmallPathEnabled = isEnabled;
+    }
+
+    void SetSignatureKernel(SignatureKernel kernel)
+    {
+        m_signatureKernel = kernel;
+    }
+
+    [[nodiscard]] size_t GetStatesCount() const override
+    {
+        return m_states.size();
+    }
+
+    [[nodiscard]] bool IsAlreadyMinimal() const override
+    {
+        return m_isAlreadyMinimal;
+    }
+
+    // Makes Minimize fill the report returned by GetReport.
+    void SetReportEnabled(bool isEnabled)
+    {
+        m_isReportEnabled = isEnabled;
+    }
+
+    [[nodiscard]] const MinimizationReport& GetReport() const
+    {
+        return m_report;
     }
 
 private:
+    using SmallMealyMinimizer = SmallMinimizer<64, 16>;
+    static constexpr int UNREACHABLE_STATE = -1;
+
     vector<string> m_states;
     vector<string> m_inputSymbols;
-    vector<vector<pair<string, string>>> m_transitions;
+    // Cells are indexed [input][state], outputs in the same order as one flat table.
+    vector<vector<string>> m_nextStateNames;
+    OutputTable m_outputs;
+    bool m_isSmallPathEnabled = true;
+    SignatureKernel m_signatureKernel = SignatureHasher::GetBestKernel();
+    bool m_isReportEnabled = false;
+    bool m_isAlreadyMinimal = false;
+    MinimizationReport m_report;
+
+    // Split history of the refinement: a node per block that appeared when its parent split,
+    // round 0 is the split by outputs. A block that does not split keeps its node.
+    struct SplitNode
+    {
+        int parent;
+        int round;
+        size_t representative;
+    };
 
-    void ClearUnreachableState ()
+    struct SplitTree
     {
-        unordered_set<string> reachable;
-        queue<string> toVisit;
-        toVisit.push(m_states[0]);
+        vector<SplitNode> nodes;
+        // Node of every block of the current partition.
+        vector<int> blockNodes;
+    };
 
-        while (!toVisit.empty())
+    // Dense input-major table of next state indexes: next[input * states + state].
+    vector<uint32_t> GetNextStateTable() const
+    {
+        unordered_map<string, uint32_t> stateIndexes;
+        for (size_t i = 0; i < m_states.size(); ++i)
         {
-            string current = toVisit.front();
-            toVisit.pop();
+            stateIndexes.emplace(m_states[i], i);
+        }
 
-            if (reachable.count(current)) continue;
-            reachable.insert(current);
+        vector<uint32_t> nextStates;
+        nextStates.reserve(m_inputSymbols.size() * m_states.size());
+        for (const auto &row : m_nextStateNames)
+        {
+            for (const auto &nextState : row)
+            {
+                auto it = stateIndexes.find(nextState);
+                if (it == stateIndexes.end())
+                {
+                    throw invalid_argument("Unknown state " + nextState);
+                }
+                nextStates.push_back(it->second);
+            }
+        }
+
+        return nextStates;
+    }
+
+    // Reachability and refinement on stack tables, unreachable states get UNREACHABLE_STATE.
+    vector<int> GetSmallPartition(const vector<uint32_t> &nextStates) const
+    {
+        SmallMealyMinimizer minimizer(m_inputSymbols.size());
+
+        for (size_t i = 0; i < m_inputSymbols.size(); ++i)
+        {
+            for (size_t j = 0; j < m_states.size(); ++j)
+            {
+                minimizer.SetTransition(i, j, nextStates[i * m_states.size() + j]);
+            }
+        }
+
+        vector<int> initialPartition = InitializePartition();
+        for (size_t j = 0; j < m_states.size(); ++j)
+        {
+            minimizer.SetInitialClass(j, initialPartition[j]);
+        }
+
+        auto reachable = minimizer.GetReachableStates(0);
+        array<uint8_t, SmallMealyMinimizer::MAX_STATES> blockOf {};
+        minimizer.Minimize(reachable, blockOf);
+
+        vector<int> partition(m_states.size(), UNREACHABLE_STATE);
+        for (size_t j = 0; j < m_states.size(); ++j)
+        {
+            if (reachable >> j & 1)
+            {
+                partition[j] = blockOf[j];
+            }
+        }
+
+        return partition;
+    }
+
+    // Returns false when every state is reachable, the table is left untouched then.
+    bool ClearUnreachableState()
+    {
+        unordered_map<string, size_t> stateIndexes;
+        for (size_t i = 0; i < m_states.size(); ++i)
+        {
+            stateIndexes.emplace(m_states[i], i);
+        }
+
+        vector<bool> reachable(m_states.size(), false);
+        vector<size_t> toVisit = {0};
+        reachable[0] = true;
 
-            int stateIndex = find(m_states.begin(), m_states.end(), current) - m_states.begin();
-            for (const auto &transition : m_transitions)
+        for (size_t index = 0; index < toVisit.size(); ++index)
+        {
+            for (const auto &row : m_nextStateNames)
             {
-                string nextState = transition[stateIndex].first;
-                if (!reachable.count(nextState))
+                auto it = stateIndexes.find(row[toVisit[index]]);
+                if (it == stateIndexes.end())
+                {
+                    throw invalid_argument("Unknown state " + row[toVisit[index]]);
+                }
+                if (!reachable[it->second])
                 {
-                    toVisit.push(nextState);
+                    reachable[it->second] = true;
+                    toVisit.push_back(it->second);
                 }
             }
         }
 
+        if (toVisit.size() == m_states.size())
+        {
+            return false;
+        }
+
         vector<string> reducedStates;
-        vector<vector<pair<string, string>>> reducedTransitions;
+        vector<vector<string>> reducedNextStateNames;
+        OutputTable reducedOutputs = m_outputs.CloneDictionary();
+        reducedOutputs.Reserve(toVisit.size() * m_inputSymbols.size());
 
-        for (const string &state : m_states)
+        for (size_t i = 0; i < m_states.size(); ++i)
         {
-            if (reachable.count(state)) reducedStates.push_back(state);
+            if (reachable[i]) reducedStates.push_back(m_states[i]);
         }
 
-        for (const auto &row : m_transitions)
+        for (size_t input = 0; input < m_inputSymbols.size(); ++input)
         {
-            vector<pair<string, string>> newRow;
+            vector<string> newRow;
             for (size_t i = 0; i < m_states.size(); ++i)
             {
-                if (reachable.count(m_states[i]))
+                if (reachable[i])
                 {
-                    newRow.push_back(row[i]);
+                    newRow.push_back(m_nextStateNames[input][i]);
+                    reducedOutputs.Append(m_outputs.Get(input * m_states.size() + i));
                 }
             }
-            reducedTransitions.push_back(newRow);
+            reducedNextStateNames.push_back(move(newRow));
         }
 
         m_states = move(reducedStates);
-        m_transitions = move(reducedTransitions);
+        m_nextStateNames = move(reducedNextStateNames);
+        m_outputs = move(reducedOutputs);
+
+        return true;
     }
 
-    vector<int> InitializePartition()
+    // Groups states by their outputs one input at a time, keying each pass on (block so far, output code).
+    // Blocks are numbered in the order of their first state.
+    vector<int> InitializePartition() const
     {
-        vector<int> partition(m_states.size(), 0);
-        unordered_map<string, int> outputMap;
+        size_t statesCount = m_states.size();
+        vector<int> partition(statesCount, 0);
+        size_t blocksCount = 1;
 
-        for (size_t i = 0; i < m_states.size(); ++i)
+        for (size_t i = 0; i < m_inputSymbols.size(); ++i)
+        {
+            StatePairMap blocks(min(statesCount, blocksCount * m_outputs.GetSymbolsCount()));
+            for (size_t j = 0; j < statesCount; ++j)
+            {
+                uint64_t key = StatePairMap::Pack(partition[j], m_outputs.Get(i * statesCount + j));
+                partition[j] = static_cast<int>(blocks.Insert(key, static_cast<uint32_t>(blocks.GetSize())).first);
+            }
+            blocksCount = blocks.GetSize();
+        }
+
+        return partition;
+    }
+
+    [[nodiscard]] const string &GetOutput(size_t input, size_t state) const
+    {
+        return m_outputs.GetSymbol(m_outputs.Get(input * m_states.size() + state));
+    }
+
+    // Each round gives every state a new block by its signature (own block and the block
+    // of each successor). Signatures are hashed in bulk and matched against the block
+    // representatives in an open-addressing table, so a round does not allocate.
+    // With a split tree the representative of every new block is recorded as a split witness.
+    void RefinePartition(vector<int> &partition, const vector<uint32_t> &nextStates,
+                         SplitTree *splitTree = nullptr) const
+    {
+        size_t statesCount = m_states.size();
+        size_t inputsCount = m_inputSymbols.size();
+
+        vector<uint32_t> hashes(statesCount);
+        vector<int> newPartition(statesCount);
+        // Slots hold a block representative + 1, zero marks an empty slot.
+        vector<uint32_t> slots(bit_ceil(statesCount * 2));
+        size_t mask = slots.size() - 1;
+        size_t blocksCount = CountBlocks(partition);
+        vector<size_t> representatives;
+
+        // A discrete partition cannot split any further.
+        for (int round = 1; blocksCount < statesCount; ++round)
         {
-            string outputs;
-            for (const auto &row : m_transitions)
+            SignatureHasher::Compute(m_signatureKernel, partition.data(), nextStates.data(),
+                                     statesCount, inputsCount, hashes.data());
+            fill(slots.begin(), slots.end(), 0);
+            size_t newBlocksCount = 0;
+            representatives.clear();
+
+            for (size_t i = 0; i < statesCount; ++i)
+            {
+                size_t slot = hashes[i] & mask;
+                while (slots[slot] != 0 && !IsSameSignature(partition, nextStates, hashes, slots[slot] - 1, i))
+                {
+                    slot = (slot + 1) & mask;
+                }
+
+                if (slots[slot] == 0)
+                {
+                    slots[slot] = i + 1;
+                    newPartition[i] = newBlocksCount++;
+                    if (splitTree != nullptr)
+                    {
+                        representatives.push_back(i);
+                    }
+                }
+                else
+                {
+                    newPartition[i] = newPartition[slots[slot] - 1];
+                }
+            }
+
+            if (splitTree != nullptr)
             {
-                outputs += row[i].second + ",";
+                RecordSplits(round, partition, representatives, *splitTree);
             }
-            if (outputMap.find(outputs) == outputMap.end())
+            partition.swap(newPartition);
+
+            // Blocks are only ever split, so the partition is stable once their count stops growing.
+            if (newBlocksCount == blocksCount)
             {
-                outputMap[outputs] = outputMap.size();
+                break;
             }
-            partition[i] = outputMap[outputs];
+            blocksCount = newBlocksCount;
         }
+    }
 
-        return partition;
+    bool IsSameSignature(const vector<int> &partition, const vector<uint32_t> &nextStates,
+                         const vector<uint32_t> &hashes, size_t first, size_t second) const
+    {
+        if (hashes[first] != hashes[second] || partition[first] != partition[second])
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < m_inputSymbols.size(); ++i)
+        {
+            size_t row = i * m_states.size();
+            if (partition[nextStates[row + first]] != partition[nextStates[row + second]])
+            {
+                return false;
+            }
+        }
+
+        return true;
     }
 
-    void RefinePartition(vector<int> &partition)
+    void InitializeSplitTree(const vector<int> &partition, SplitTree &splitTree) const
     {
-        bool updated;
-        do
+        vector<size_t> representatives;
+        for (size_t i = 0; i < partition.size(); ++i)
         {
-            updated = false;
-            unordered_map<string, int> newPartitionMap;
+            if (static_cast<size_t>(partition[i]) == representatives.size())
+            {
+                representatives.push_back(i);
+            }
+        }
 
-            for (size_t i = 0; i < m_states.size(); ++i)
+        splitTree.nodes.push_back({-1, -1, 0});
+        splitTree.blockNodes.assign(1, 0);
+        RecordSplits(0, vector<int>(partition.size(), 0), representatives, splitTree);
+    }
+
+    // Blocks of the new partition are numbered by their representatives, in order.
+    static void RecordSplits(int round, const vector<int> &partition, const vector<size_t> &representatives,
+                             SplitTree &splitTree)
+    {
+        vector<int> childrenCount(splitTree.blockNodes.size(), 0);
+        for (size_t representative : representatives)
+        {
+            ++childrenCount[partition[representative]];
+        }
+
+        vector<int> blockNodes(representatives.size());
+        for (size_t i = 0; i < representatives.size(); ++i)
+        {
+            int parentBlock = partition[representatives[i]];
+            int parent = splitTree.blockNodes[parentBlock];
+            if (childrenCount[parentBlock] == 1)
             {
-                string key = to_string(partition[i]) + ",";
-                for (const auto &row : m_transitions)
+                blockNodes[i] = parent;
+                continue;
+            }
+
+            blockNodes[i] = static_cast<int>(splitTree.nodes.size());
+            splitTree.nodes.push_back({parent, round, representatives[i]});
+        }
+
+        splitTree.blockNodes = move(blockNodes);
+    }
+
+    // Node of the block that held the state after the given round.
+    static int GetNodeAtRound(const SplitTree &splitTree, const vector<int> &partition, size_t state, int round)
+    {
+        int node = splitTree.blockNodes[partition[state]];
+        while (splitTree.nodes[node].round > round)
+        {
+            node = splitTree.nodes[node].parent;
+        }
+
+        return node;
+    }
+
+    // Walks the split witnesses down from the split that separated the two nodes. States split
+    // in round r agree on all words shorter than r + 1 symbols, so the word is a shortest one.
+    vector<string> GetSeparatingWord(const SplitTree &splitTree, const vector<int> &partition,
+                                     const vector<uint32_t> &nextStates, int first, int second) const
+    {
+        vector<string> word;
+        auto &nodes = splitTree.nodes;
+
+        while (true)
+        {
+            while (nodes[first].parent != nodes[second].parent)
+            {
+                if (nodes[first].round >= nodes[second].round)
                 {
-                    int nextIndex = find(m_states.begin(), m_states.end(), row[i].first) - m_states.begin();
-                    key += to_string(partition[nextIndex]) + ",";
+                    first = nodes[first].parent;
                 }
-                if (newPartitionMap.find(key) == newPartitionMap.end())
+                else
                 {
-                    newPartitionMap[key] = newPartitionMap.size();
+                    second = nodes[second].parent;
                 }
-                if (partition[i] != newPartitionMap[key])
+            }
+
+            size_t firstState = nodes[first].representative;
+            size_t secondState = nodes[second].representative;
+            int round = nodes[first].round;
+
+            for (size_t i = 0; i < m_inputSymbols.size(); ++i)
+            {
+                if (round == 0)
+                {
+                    size_t row = i * m_states.size();
+                    if (m_outputs.Get(row + firstState) != m_outputs.Get(row + secondState))
+                    {
+                        word.push_back(m_inputSymbols[i]);
+                        return word;
+                    }
+                    continue;
+                }
+
+                size_t row = i * m_states.size();
+                int firstNext = GetNodeAtRound(splitTree, partition, nextStates[row + firstState], round - 1);
+                int secondNext = GetNodeAtRound(splitTree, partition, nextStates[row + secondState], round - 1);
+                if (firstNext != secondNext)
                 {
-                    updated = true;
+                    word.push_back(m_inputSymbols[i]);
+                    first = firstNext;
+                    second = secondNext;
+                    break;
                 }
-                partition[i] = newPartitionMap[key];
             }
-        } while (updated);
+        }
+    }
+
+    // Refinement numbers blocks by their first state, the same order BuildMinimizedAutomata names them in.
+    void BuildReport(const vector<string> &originalStates, const vector<int> &partition,
+                     const vector<uint32_t> &nextStates, const SplitTree &splitTree)
+    {
+        m_report = MinimizationReport();
+
+        unordered_map<string, size_t> stateIndexes;
+        for (size_t i = 0; i < m_states.size(); ++i)
+        {
+            stateIndexes.emplace(m_states[i], i);
+        }
+
+        for (const string &state : originalStates)
+        {
+            auto it = stateIndexes.find(state);
+            m_report.AddStateMapping(state, it == stateIndexes.end() ? "" : GetMinimizedStateName(partition[it->second]));
+        }
+
+        for (size_t block = 1; block < splitTree.blockNodes.size(); ++block)
+        {
+            int first = splitTree.blockNodes[block - 1];
+            int second = splitTree.blockNodes[block];
+            m_report.AddSeparatingWord(GetMinimizedStateName(block - 1), GetMinimizedStateName(block),
+                                       GetSeparatingWord(splitTree, partition, nextStates, first, second));
+        }
+    }
+
+    [[nodiscard]] string GetMinimizedStateName(size_t block) const
+    {
+        return m_states[0][0] + to_string(block);
+    }
+
+    static size_t CountBlocks(const vector<int> &partition)
+    {
+        return unordered_set<int>(partition.begin(), partition.end()).size();
+    }
+
+    static bool IsDiscretePartition(const vector<int> &partition)
+    {
+        return find(partition.begin(), partition.end(), UNREACHABLE_STATE) == partition.end() &&
+               CountBlocks(partition) == partition.size();
+    }
+
+    // Names a discrete partition gets from BuildMinimizedAutomata, without rebuilding the table.
+    void RenameStates(const vector<uint32_t> &nextStates)
+    {
+        vector<string> names(m_states.size());
+        for (size_t i = 0; i < m_states.size(); ++i)
+        {
+            names[i] = GetMinimizedStateName(i);
+        }
+
+        for (size_t i = 0; i < m_inputSymbols.size(); ++i)
+        {
+            for (size_t j = 0; j < m_states.size(); ++j)
+            {
+                m_nextStateNames[i][j] = names[nextStates[i * m_states.size() + j]];
+            }
+        }
+
+        m_states = move(names);
     }
 
-    void BuildMinimizedAutomata(const vector<int> &partition)
+    void BuildMinimizedAutomata(const vector<int> &partition, const vector<uint32_t> &nextStates)
     {
         unordered_map<int, string> stateMap;
         vector<string> minimizedStates;
-        vector<vector<pair<string, string>>> minimizedTransitions(m_inputSymbols.size());
-        char sim = m_states[0][0];
+        vector<size_t> representatives;
+        vector<vector<string>> minimizedNextStateNames(m_inputSymbols.size());
+        OutputTable minimizedOutputs = m_outputs.CloneDictionary();
 
         for (size_t i = 0; i < m_states.size(); ++i)
         {
+            if (partition[i] == UNREACHABLE_STATE)
+            {
+                continue;
+            }
             if (stateMap.find(partition[i]) == stateMap.end())
             {
-                stateMap[partition[i]] = sim + to_string(stateMap.size());
+                stateMap[partition[i]] = GetMinimizedStateName(stateMap.size());
                 minimizedStates.push_back(stateMap[partition[i]]);
+                representatives.push_back(i);
             }
         }
 
+        minimizedOutputs.Reserve(representatives.size() * m_inputSymbols.size());
         for (size_t i = 0; i < m_inputSymbols.size(); ++i)
         {
-            for (size_t j = 0; j < minimizedStates.size(); ++j)
+            for (size_t representative : representatives)
             {
-                int nextIndex = find(m_states.begin(), m_states.end(), m_transitions[i][j].first) - m_states.begin();
-                string nextState = stateMap[partition[nextIndex]];
-                string outputSymbol = m_transitions[i][j].second;
-                minimizedTransitions[i].emplace_back(nextState, outputSymbol);
+                uint32_t nextIndex = nextStates[i * m_states.size() + representative];
+                minimizedNextStateNames[i].push_back(stateMap[partition[nextIndex]]);
+                minimizedOutputs.Append(m_outputs.Get(i * m_states.size() + representative));
             }
         }
 
         m_states = move(minimizedStates);
-        m_transitions = move(minimizedTransitions);
+        m_nextStateNames = move(minimizedNextStateNames);
+        m_outputs = move(minimizedOutputs);
     }
 };
 
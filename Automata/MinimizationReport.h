@@ -0,0 +1,71 @@
+#pragma once
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// What minimization did to a machine: the minimized state of every original state
+// (empty for unreachable ones) and a shortest word separating each pair of
+// consecutive minimized states.
+class MinimizationReport
+{
+public:
+    void AddStateMapping(const std::string& state, const std::string& minimizedState)
+    {
+        m_stateMapping.emplace_back(state, minimizedState);
+    }
+
+    void AddSeparatingWord(const std::string& first, const std::string& second, std::vector<std::string> word)
+    {
+        m_separatingWords.push_back({first, second, std::move(word)});
+    }
+
+    [[nodiscard]] const std::vector<std::pair<std::string, std::string>>& GetStateMapping() const
+    {
+        return m_stateMapping;
+    }
+
+    void PrintToStream(std::ostream& file) const
+    {
+        file << "state;minimized" << std::endl;
+        for (auto& [state, minimizedState]: m_stateMapping)
+        {
+            file << state << ";" << minimizedState << "\n";
+        }
+
+        file << "\nfirst;second;word" << std::endl;
+        for (auto& separatingWord: m_separatingWords)
+        {
+            file << separatingWord.first << ";" << separatingWord.second << ";";
+            for (size_t i = 0; i < separatingWord.word.size(); ++i)
+            {
+                file << (i == 0 ? "" : " ") << separatingWord.word[i];
+            }
+            file << "\n";
+        }
+    }
+
+    void PrintToFile(const std::string& filename) const
+    {
+        std::ofstream file(filename);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Could not open output file " + filename);
+        }
+
+        PrintToStream(file);
+    }
+
+private:
+    struct SeparatingWord
+    {
+        std::string first;
+        std::string second;
+        std::vector<std::string> word;
+    };
+
+    std::vector<std::pair<std::string, std::string>> m_stateMapping;
+    std::vector<SeparatingWord> m_separatingWords;
+};
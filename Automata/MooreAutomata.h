@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <fstream>
 #include <map>
 #include <ostream>
@@ -7,7 +8,11 @@
 #include <vector>
 
 #include "Group.h"
+#include "IAutomata.h"
+#include "ParallelBlockRefiner.h"
+#include "SmallMinimizer.h"
 #include "Transition.h"
+#include "WorkStealingScheduler.h"
 
 using Transitions = std::map<std::string, std::map<std::string, Transition>>;
 using TransitionTable = std::map<std::set<std::string>, std::map<std::string, std::set<std::string>>>;
@@ -17,20 +22,30 @@ constexpr std::string E_CLOSE = "ε";
 class MooreAutomata final : public IAutomata
 {
 public:
-    void ReadFromFile(const std::string &filename) override
+    MooreAutomata() = default;
+
+    MooreAutomata(std::set<std::string> inputs, std::set<std::string> states, Transitions transitions,
+                  std::string startState, std::set<std::string> finalStates)
+        : m_inputs(std::move(inputs))
+        , m_states(std::move(states))
+        , m_transitions(std::move(transitions))
+        , m_startState(std::move(startState))
+        , m_finalStates(std::move(finalStates))
     {
-        std::ifstream file(filename);
-        if (!file.is_open())
-        {
-            throw std::invalid_argument("Could not open input file " + filename);
-        }
+    }
 
+    void ReadFromStream(std::istream& file) override
+    {
         std::string line;
         std::getline(file, line);
         auto finalStateIndexes = GetFinalStateIndex(line);
 
         std::getline(file, line);
         auto states = GetStates(line);
+        if (states.empty())
+        {
+            throw std::invalid_argument("No states in table header");
+        }
 
         m_startState = states.front();
         m_finalStates = GetFinalStatesFromIndexes(finalStateIndexes, states);
@@ -41,14 +56,8 @@ public:
         m_states = GetSetFromStringVector(states);
     }
 
-    void PrintToFile(const std::string& filename) override
+    void PrintToStream(std::ostream& file) override
     {
-        std::ofstream file(filename);
-        if (!file.is_open())
-        {
-            throw std::runtime_error("Could not open output file " + filename);
-        }
-
         std::string outputs = ";";
         std::string states = ";";
 
@@ -93,20 +102,84 @@ public:
             }
             file << "\n";
         }
-
-        file.close();
     }
 
+    // An already minimal machine only gets the new state names, the table is not rebuilt.
     void Minimize()
     {
+        size_t statesCount = m_states.size();
         RemoveImpossibleStates();
         std::map<std::string, std::vector<Group>> groups;
-        StatesGrouping(groups);
+        if ((!m_isSmallPathEnabled || !SmallStatesGrouping(groups)) && !ParallelStatesGrouping(groups))
+        {
+            StatesGrouping(groups);
+        }
+
+        m_isAlreadyMinimal = m_states.size() == statesCount && CountGroups(groups) == statesCount;
+        if (m_isAlreadyMinimal)
+        {
+            RenameStates(groups);
+            return;
+        }
+
         BuildMinimizedAutomata(groups);
     }
 
+    void SetSmallPathEnabled(bool isEnabled)
+    {
+        m_isSmallPathEnabled = isEnabled;
+    }
+
+    // Deterministic automata with at least minStates states are refined on threadsCount threads,
+    // blocks bigger than chunkStates states are split in several pieces. One thread by default,
+    // the caller knows how many automata run at once and gives the budget.
+    void SetParallelRefinement(size_t threadsCount, size_t minStates = PARALLEL_MIN_STATES,
+                               size_t chunkStates = PARALLEL_CHUNK_STATES)
+    {
+        m_threadsCount = threadsCount;
+        m_parallelMinStates = minStates;
+        m_parallelChunkStates = chunkStates;
+    }
+
+    [[nodiscard]] size_t GetStatesCount() const override
+    {
+        return m_states.size();
+    }
+
+    [[nodiscard]] bool IsAlreadyMinimal() const override
+    {
+        return m_isAlreadyMinimal;
+    }
+
+    [[nodiscard]] const std::set<std::string>& GetInputs() const
+    {
+        return m_inputs;
+    }
+
+    [[nodiscard]] const std::set<std::string>& GetStates() const
+    {
+        return m_states;
+    }
+
+    [[nodiscard]] const Transitions& GetTransitions() const
+    {
+        return m_transitions;
+    }
+
+    [[nodiscard]] const std::string& GetStartState() const
+    {
+        return m_startState;
+    }
+
+    [[nodiscard]] const std::set<std::string>& GetFinalStates() const
+    {
+        return m_finalStates;
+    }
+
 private:
     static constexpr char NEW_STATE_CHAR = 'X';
+    static constexpr size_t PARALLEL_MIN_STATES = 1 << 14;
+    static constexpr size_t PARALLEL_CHUNK_STATES = 1 << 12;
 
     std::set<std::string> m_inputs;
     std::set<std::string> m_states;
@@ -116,6 +189,15 @@ private:
     std::string m_startState;
     std::set<std::string> m_finalStates;
 
+    bool m_isSmallPathEnabled = true;
+    bool m_isAlreadyMinimal = false;
+
+    size_t m_threadsCount = 1;
+    size_t m_parallelMinStates = PARALLEL_MIN_STATES;
+    size_t m_parallelChunkStates = PARALLEL_CHUNK_STATES;
+
+    using SmallMooreMinimizer = SmallMinimizer<64, 16>;
+
     void BuildMinimizedAutomata(std::map<std::string, std::vector<Group>>& groups)
     {
         auto newStateNames = GetNewStateNames(groups);
@@ -159,6 +241,48 @@ private:
         m_transitions = newTransitions;
     }
 
+    // Names a discrete partition gets from BuildMinimizedAutomata, without rebuilding the table:
+    // the nodes of the states and of the transitions only get their new names.
+    void RenameStates(std::map<std::string, std::vector<Group>>& groups)
+    {
+        auto newStateNames = GetNewStateNames(groups);
+
+        std::set<std::string> newStates;
+        while (!m_states.empty())
+        {
+            auto node = m_states.extract(m_states.begin());
+            node.value() = newStateNames[node.value()];
+            newStates.insert(std::move(node));
+        }
+
+        std::set<std::string> newInputs;
+        Transitions newTransitions;
+        while (!m_transitions.empty())
+        {
+            auto node = m_transitions.extract(m_transitions.begin());
+            auto newName = newStateNames.find(node.key());
+            if (newName == newStateNames.end())
+            {
+                continue;
+            }
+
+            node.key() = newName->second;
+            for (auto& [input, transition]: node.mapped())
+            {
+                newInputs.insert(input);
+                auto newNextState = newStateNames.find(transition.GetFirstState());
+                transition.RenameFirstState(newNextState == newStateNames.end() ? "" : newNextState->second);
+            }
+            newTransitions.insert(std::move(node));
+        }
+
+        m_finalStates = GetNewFinalStates(groups, newStateNames);
+        m_startState = newStateNames[m_startState];
+        m_inputs = std::move(newInputs);
+        m_states = std::move(newStates);
+        m_transitions = std::move(newTransitions);
+    }
+
     std::set<std::string> GetNewFinalStates(std::map<std::string, std::vector<Group>>& groups,
                                             std::map<std::string, std::string>& newStateNames) const
     {
@@ -178,7 +302,7 @@ private:
         std::map<std::string, std::string> newStateNames;
         unsigned stateIndex = 1;
 
-        for (auto it: groups)
+        for (auto& it: groups)
         {
             for (auto& group: it.second)
             {
@@ -195,6 +319,159 @@ private:
         return newStateNames;
     }
 
+    // Same grouping as StatesGrouping on fixed-size tables. Returns false when the automata
+    // is too big or not deterministic, the groups are left untouched then.
+    bool SmallStatesGrouping(std::map<std::string, std::vector<Group>>& groups) const
+    {
+        // One more state stands for missing transitions, so they never match an existing one.
+        if (!SmallMooreMinimizer::Fits(m_states.size() + 1, m_inputs.size()))
+        {
+            return false;
+        }
+
+        std::vector<std::string> states(m_states.begin(), m_states.end());
+        size_t deadState = states.size();
+        SmallMooreMinimizer minimizer(m_inputs.size());
+
+        for (size_t inputIndex = 0; auto& input: m_inputs)
+        {
+            for (size_t state = 0; state < states.size(); ++state)
+            {
+                size_t nextState = deadState;
+                auto stateTransitions = m_transitions.find(states[state]);
+
+                if (stateTransitions != m_transitions.end() && stateTransitions->second.contains(input))
+                {
+                    auto& nextStates = stateTransitions->second.at(input).GetStates();
+                    auto it = std::lower_bound(states.begin(), states.end(), *nextStates.begin());
+                    if (nextStates.size() != 1 || it == states.end() || *it != *nextStates.begin())
+                    {
+                        return false;
+                    }
+                    nextState = it - states.begin();
+                }
+
+                minimizer.SetTransition(inputIndex, state, nextState);
+            }
+
+            minimizer.SetTransition(inputIndex++, deadState, deadState);
+        }
+
+        for (size_t state = 0; state < states.size(); ++state)
+        {
+            minimizer.SetInitialClass(state, IsFinalState(states[state]) ? 1 : 0);
+        }
+        minimizer.SetInitialClass(deadState, 2);
+
+        std::array<uint8_t, SmallMooreMinimizer::MAX_STATES> blockOf {};
+        size_t blocksCount = minimizer.MinimizeInRounds((SmallMooreMinimizer::StateMask(2) << deadState) - 1, blockOf);
+
+        // Groups are created in block order, which is the order StatesGrouping gives them.
+        std::array<size_t, SmallMooreMinimizer::MAX_STATES> blockFirstStates {};
+        blockFirstStates.fill(SmallMooreMinimizer::MAX_STATES);
+        for (size_t state = states.size(); state-- > 0;)
+        {
+            blockFirstStates[blockOf[state]] = state;
+        }
+
+        std::array<size_t, SmallMooreMinimizer::MAX_STATES> blockGroups {};
+        for (size_t block = 0; block < blocksCount; ++block)
+        {
+            if (blockFirstStates[block] != SmallMooreMinimizer::MAX_STATES)
+            {
+                auto& keyGroups = groups[IsFinalState(states[blockFirstStates[block]]) ? "F" : " "];
+                blockGroups[block] = keyGroups.size();
+                keyGroups.emplace_back();
+            }
+        }
+
+        for (size_t state = 0; state < states.size(); ++state)
+        {
+            groups[IsFinalState(states[state]) ? "F" : " "][blockGroups[blockOf[state]]].AddState(states[state]);
+        }
+
+        return true;
+    }
+
+    // Same grouping as StatesGrouping, with the blocks split on several threads. Returns false
+    // when the automata is too small or not deterministic, the groups are left untouched then.
+    bool ParallelStatesGrouping(std::map<std::string, std::vector<Group>>& groups) const
+    {
+        if (m_states.size() < m_parallelMinStates)
+        {
+            return false;
+        }
+
+        std::vector<std::string> states(m_states.begin(), m_states.end());
+        ParallelBlockRefiner refiner(states.size(), m_inputs.size(), m_parallelChunkStates);
+
+        for (size_t state = 0; state < states.size(); ++state)
+        {
+            // StatesGrouping rejects states without transitions, leave them to it.
+            auto stateTransitions = m_transitions.find(states[state]);
+            if (stateTransitions == m_transitions.end())
+            {
+                return false;
+            }
+
+            for (size_t inputIndex = 0; auto& input: m_inputs)
+            {
+                uint32_t nextState = ParallelBlockRefiner::NO_STATE;
+                auto transition = stateTransitions->second.find(input);
+
+                if (transition != stateTransitions->second.end())
+                {
+                    auto& nextStates = transition->second.GetStates();
+                    if (nextStates.size() != 1)
+                    {
+                        return false;
+                    }
+
+                    auto it = std::lower_bound(states.begin(), states.end(), *nextStates.begin());
+                    if (it == states.end() || *it != *nextStates.begin())
+                    {
+                        return false;
+                    }
+                    nextState = static_cast<uint32_t>(it - states.begin());
+                }
+
+                refiner.SetTransition(inputIndex++, state, nextState);
+            }
+        }
+
+        // Non-final states first, as the " " key goes before "F" in InitGroups.
+        for (bool isFinal: {false, true})
+        {
+            std::vector<uint32_t> blockStates;
+            for (uint32_t state = 0; state < states.size(); ++state)
+            {
+                if (IsFinalState(states[state]) == isFinal)
+                {
+                    blockStates.push_back(state);
+                }
+            }
+
+            if (!blockStates.empty())
+            {
+                refiner.AddInitialBlock(blockStates);
+            }
+        }
+
+        WorkStealingScheduler scheduler(m_threadsCount);
+        for (auto& block: refiner.Refine(scheduler))
+        {
+            Group group;
+            for (uint32_t state: block)
+            {
+                group.AddState(states[state]);
+            }
+
+            groups[IsFinalState(states[block.front()]) ? "F" : " "].push_back(std::move(group));
+        }
+
+        return true;
+    }
+
     void StatesGrouping(std::map<std::string, std::vector<Group>>& groups)
     {
         std::map<std::string, Group*> stateToGroup;
@@ -203,73 +480,87 @@ private:
         while (true)
         {
             bool isChangedSize = false;
+            // Groups of the previous round stay alive while the new ones are built,
+            // stateToGroup keeps pointing to them until the round is over.
+            std::map<std::string, std::vector<Group>> newGroups;
 
             for (auto& pair: groups)
             {
-                std::vector<Group> newGroups;
+                auto& splitGroups = newGroups[pair.first];
 
                 for (auto& group: pair.second)
                 {
                     if (group.GetStatesCount() == 1)
                     {
+                        splitGroups.push_back(group);
                         continue;
                     }
 
-                    std::string mainState = group.GetMainState();
+                    size_t firstSplitGroup = splitGroups.size();
 
                     for (auto& state: group.GetStates())
                     {
-                        if (state == mainState)
-                        {
-                            continue;
-                        }
+                        auto it = std::find_if(splitGroups.begin() + firstSplitGroup, splitGroups.end(),
+                                               [&](Group& splitGroup) {
+                                                   return IsStatesTransitionsEquals(splitGroup.GetMainState(),
+                                                                                    state, stateToGroup);
+                                               });
 
-                        if (!IsStatesTransitionsEquals(mainState, state, stateToGroup))
+                        if (it != splitGroups.end())
                         {
-                            group.RemoveState(state);
-
-                            Group newGroup;
-                            newGroup.AddState(state);
-
-                            newGroups.emplace_back(std::move(newGroup));
-                            stateToGroup[state] = &newGroups.back();
-                        }
-                    }
-                }
-
-                for (auto& it: newGroups)
-                {
-                    bool isAdded = false;
-                    for (auto& group: pair.second)
-                    {
-                        std::string mainState = group.GetMainState();
-                        if (IsStatesTransitionsEquals(mainState, it.GetMainState(), stateToGroup))
-                        {
-                            group.AddState(it.GetMainState());
-                            isAdded = true;
-                            break;
+                            it->AddState(state);
+                            continue;
                         }
-                    }
 
-                    if (!isAdded)
-                    {
-                        pair.second.emplace_back(it);
+                        Group newGroup;
+                        newGroup.AddState(state);
+                        splitGroups.emplace_back(std::move(newGroup));
                     }
 
-                    if (!isChangedSize)
+                    if (splitGroups.size() - firstSplitGroup > 1)
                     {
                         isChangedSize = true;
                     }
                 }
             }
 
-            if (!isChangedSize)
+            groups = std::move(newGroups);
+            UpdateStateToGroup(groups, stateToGroup);
+
+            // Once every state has its own group nothing can split any more.
+            if (!isChangedSize || CountGroups(groups) == m_states.size())
             {
                 break;
             }
         }
     }
 
+    static size_t CountGroups(const std::map<std::string, std::vector<Group>>& groups)
+    {
+        size_t groupsCount = 0;
+        for (auto& pair: groups)
+        {
+            groupsCount += pair.second.size();
+        }
+
+        return groupsCount;
+    }
+
+    static void UpdateStateToGroup(std::map<std::string, std::vector<Group>>& groups,
+                                   std::map<std::string, Group*>& stateToGroup)
+    {
+        for (auto& pair: groups)
+        {
+            for (auto& group: pair.second)
+            {
+                for (auto& state: group.GetStates())
+                {
+                    stateToGroup[state] = &group;
+                }
+            }
+        }
+    }
+
     bool IsStatesTransitionsEquals(const std::string& firstState, const std::string& secondState,
                                    std::map<std::string, Group*>& stateToGroup)
     {
@@ -288,8 +579,8 @@ private:
                 return false;
             }
 
-            auto nextStatesFromFirstState = transition.GetStates();
-            auto nextStatesFromSecondState = secondStateTransitions.at(input).GetStates();
+            auto& nextStatesFromFirstState = transition.GetStates();
+            auto& nextStatesFromSecondState = secondStateTransitions.at(input).GetStates();
 
             if (nextStatesFromFirstState.size() != nextStatesFromSecondState.size())
             {
@@ -313,15 +604,18 @@ private:
     {
         Group group;
 
-        groups.emplace("F", std::vector<Group>());
+        if (!m_finalStates.empty())
+        {
+            groups.emplace("F", std::vector<Group>());
+            groups.at("F").emplace_back(group);
+        }
+
         if (m_states.size() != m_finalStates.size())
         {
             groups.emplace(" ", std::vector<Group>());
             groups.at(" ").emplace_back(group);
         }
 
-        groups.at("F").emplace_back(group);
-
         for (auto& state: m_states)
         {
             std::string key = " ";
@@ -362,7 +656,7 @@ private:
 
             for (auto& i: m_transitions[sourceState])
             {
-                auto nextStates = i.second.GetStates();
+                auto& nextStates = i.second.GetStates();
 
                 for (const auto& state: nextStates)
                 {
@@ -420,7 +714,7 @@ private:
         }
     }
 
-    static void SetTransitionsTableData(Transitions& transitions, std::ifstream& file,
+    static void SetTransitionsTableData(Transitions& transitions, std::istream& file,
                                         std::vector<std::string>& states, std::set<std::string>& inputs)
     {
         std::string line;
@@ -481,6 +775,7 @@ private:
     static std::set<size_t> GetFinalStateIndex(const std::string& line)
     {
         std::set<size_t> finalStateIndexes {};
+        bool hasOtherMarks = false;
 
         std::stringstream ss(line);
         std::string str;
@@ -497,9 +792,15 @@ private:
             {
                 finalStateIndexes.emplace(index - 1);
             }
+            else if (!str.empty())
+            {
+                hasOtherMarks = true;
+            }
         }
 
-        if (finalStateIndexes.empty())
+        // A row of empty cells is the F row of an automaton without final states,
+        // e.g. a product with an empty language.
+        if (finalStateIndexes.empty() && hasOtherMarks)
         {
             throw std::invalid_argument("Could not find 'F' (final state) in input file " + line);
         }
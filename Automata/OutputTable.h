@@ -0,0 +1,121 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Distinct output symbols of a Mealy table numbered in the order they are first met.
+// Codes are limited to two bytes.
+class OutputDictionary
+{
+public:
+    // Returns the code of the symbol, adding it to the dictionary when it is new.
+    uint16_t Encode(const std::string& symbol)
+    {
+        auto [it, isInserted] = m_codes.emplace(symbol, static_cast<uint16_t>(m_symbols.size()));
+        if (isInserted)
+        {
+            if (m_symbols.size() > std::numeric_limits<uint16_t>::max())
+            {
+                m_codes.erase(it);
+                throw std::invalid_argument("Too many distinct output symbols");
+            }
+            m_symbols.push_back(symbol);
+        }
+
+        return it->second;
+    }
+
+    [[nodiscard]] const std::string& GetSymbol(uint16_t code) const
+    {
+        return m_symbols[code];
+    }
+
+    [[nodiscard]] size_t GetSymbolsCount() const
+    {
+        return m_symbols.size();
+    }
+
+private:
+    std::vector<std::string> m_symbols;
+    std::unordered_map<std::string, uint16_t> m_codes;
+};
+
+// Output symbols of a Mealy table, one per cell, stored as codes into an OutputDictionary.
+// Codes take one byte while the alphabet fits, two bytes after that.
+class OutputTable
+{
+public:
+    // Codes already stored are widened once the alphabet outgrows one byte.
+    uint16_t Encode(const std::string& symbol)
+    {
+        uint16_t code = m_dictionary.Encode(symbol);
+        if (IsWide() && !m_narrowCodes.empty())
+        {
+            m_wideCodes.assign(m_narrowCodes.begin(), m_narrowCodes.end());
+            m_narrowCodes = std::vector<uint8_t>();
+        }
+
+        return code;
+    }
+
+    void Append(uint16_t code)
+    {
+        if (IsWide())
+        {
+            m_wideCodes.push_back(code);
+        }
+        else
+        {
+            m_narrowCodes.push_back(static_cast<uint8_t>(code));
+        }
+    }
+
+    void Reserve(size_t cellsCount)
+    {
+        if (IsWide())
+        {
+            m_wideCodes.reserve(cellsCount);
+        }
+        else
+        {
+            m_narrowCodes.reserve(cellsCount);
+        }
+    }
+
+    [[nodiscard]] uint16_t Get(size_t cell) const
+    {
+        return IsWide() ? m_wideCodes[cell] : m_narrowCodes[cell];
+    }
+
+    [[nodiscard]] const std::string& GetSymbol(uint16_t code) const
+    {
+        return m_dictionary.GetSymbol(code);
+    }
+
+    [[nodiscard]] size_t GetSymbolsCount() const
+    {
+        return m_dictionary.GetSymbolsCount();
+    }
+
+    // An empty table over the same dictionary, for building a reduced copy of the cells.
+    [[nodiscard]] OutputTable CloneDictionary() const
+    {
+        OutputTable table;
+        table.m_dictionary = m_dictionary;
+
+        return table;
+    }
+
+private:
+    [[nodiscard]] bool IsWide() const
+    {
+        return m_dictionary.GetSymbolsCount() > std::numeric_limits<uint8_t>::max() + 1;
+    }
+
+    OutputDictionary m_dictionary;
+    std::vector<uint8_t> m_narrowCodes;
+    std::vector<uint16_t> m_wideCodes;
+};
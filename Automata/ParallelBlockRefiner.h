@@ -0,0 +1,306 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "StatePairMap.h"
+#include "WorkStealingScheduler.h"
+
+// Block by block partition refinement over an integer table, the rounds of
+// MooreAutomata::StatesGrouping run on a WorkStealingScheduler. Every block is cut into
+// chunks of at most chunkStates states that are split independently, the chunk finishing
+// last merges the chunk splits of its block, so one huge block is spread over all threads.
+// Blocks keep the order StatesGrouping gives them: the parts of a block follow each other
+// in the order their first states appear, states stay ascending inside a block.
+class ParallelBlockRefiner
+{
+public:
+    // Stands for a missing transition, it only matches another missing one.
+    static constexpr uint32_t NO_STATE = std::numeric_limits<uint32_t>::max();
+
+    ParallelBlockRefiner(size_t statesCount, size_t inputsCount, size_t chunkStates)
+        : m_statesCount(statesCount)
+        , m_inputsCount(inputsCount)
+        , m_chunkStates(static_cast<uint32_t>(std::max<size_t>(chunkStates, 1)))
+        , m_next(statesCount * inputsCount, NO_STATE)
+        , m_blockOf(statesCount)
+        , m_localClasses(statesCount)
+    {
+        m_order.reserve(statesCount);
+    }
+
+    void SetTransition(size_t input, size_t state, uint32_t nextState)
+    {
+        m_next[state * m_inputsCount + input] = nextState;
+    }
+
+    // Blocks of the initial partition in their order, the states of a block ascending.
+    void AddInitialBlock(const std::vector<uint32_t>& states)
+    {
+        auto block = static_cast<uint32_t>(m_blocks.size());
+        m_blocks.push_back({static_cast<uint32_t>(m_order.size()), static_cast<uint32_t>(m_order.size() + states.size())});
+
+        for (uint32_t state: states)
+        {
+            m_order.push_back(state);
+            m_blockOf[state] = block;
+        }
+    }
+
+    // Splits the blocks until no block splits any more.
+    std::vector<std::vector<uint32_t>> Refine(WorkStealingScheduler& scheduler)
+    {
+        while (m_blocks.size() < m_statesCount && RefineRound(scheduler))
+        {
+        }
+
+        std::vector<std::vector<uint32_t>> blocks;
+        blocks.reserve(m_blocks.size());
+        for (auto& block: m_blocks)
+        {
+            blocks.emplace_back(m_order.begin() + block.begin, m_order.begin() + block.end);
+        }
+
+        return blocks;
+    }
+
+private:
+    struct BlockRange
+    {
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    struct Chunk
+    {
+        uint32_t block;
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    // Written only by the task owning the chunk, then read by the merge of its block.
+    struct ChunkSplit
+    {
+        std::vector<uint32_t> representatives;
+        std::vector<uint32_t> classSizes;
+        std::vector<uint32_t> blockClasses;
+        std::vector<uint32_t> offsets;
+    };
+
+    struct BlockSplit
+    {
+        std::atomic<uint32_t> pendingChunks {0};
+        uint32_t firstChunk = 0;
+        uint32_t chunksCount = 0;
+        std::vector<uint32_t> classBegins;
+    };
+
+    // Returns false when no block splits.
+    bool RefineRound(WorkStealingScheduler& scheduler)
+    {
+        std::vector<Chunk> chunks;
+        m_blockSplits = std::make_unique<BlockSplit[]>(m_blocks.size());
+
+        for (uint32_t block = 0; block < m_blocks.size(); ++block)
+        {
+            auto [begin, end] = m_blocks[block];
+            if (end - begin == 1)
+            {
+                continue;
+            }
+
+            auto& blockSplit = m_blockSplits[block];
+            blockSplit.firstChunk = static_cast<uint32_t>(chunks.size());
+            for (uint32_t chunkBegin = begin; chunkBegin < end; chunkBegin += m_chunkStates)
+            {
+                chunks.push_back({block, chunkBegin, std::min<uint32_t>(chunkBegin + m_chunkStates, end)});
+            }
+            blockSplit.chunksCount = static_cast<uint32_t>(chunks.size()) - blockSplit.firstChunk;
+            blockSplit.pendingChunks.store(blockSplit.chunksCount, std::memory_order_relaxed);
+        }
+
+        m_chunkSplits.assign(chunks.size(), ChunkSplit());
+        scheduler.Run(chunks.size(), [&](size_t chunk) {
+            SplitChunk(chunks[chunk], m_chunkSplits[chunk]);
+
+            auto& blockSplit = m_blockSplits[chunks[chunk].block];
+            if (blockSplit.pendingChunks.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                MergeBlockSplit(blockSplit);
+            }
+        });
+
+        std::vector<BlockRange> newBlocks;
+        std::vector<uint32_t> firstNewBlocks(m_blocks.size());
+        for (uint32_t block = 0; block < m_blocks.size(); ++block)
+        {
+            firstNewBlocks[block] = static_cast<uint32_t>(newBlocks.size());
+
+            auto& classBegins = m_blockSplits[block].classBegins;
+            if (classBegins.empty())
+            {
+                newBlocks.push_back(m_blocks[block]);
+                continue;
+            }
+
+            for (size_t blockClass = 0; blockClass + 1 < classBegins.size(); ++blockClass)
+            {
+                newBlocks.push_back({m_blocks[block].begin + classBegins[blockClass],
+                                     m_blocks[block].begin + classBegins[blockClass + 1]});
+            }
+        }
+
+        if (newBlocks.size() == m_blocks.size())
+        {
+            return false;
+        }
+
+        std::vector<uint32_t> newOrder(m_order.size());
+        std::vector<uint32_t> newBlockOf(m_statesCount);
+        for (uint32_t block = 0; block < m_blocks.size(); ++block)
+        {
+            if (m_blockSplits[block].classBegins.empty())
+            {
+                uint32_t position = m_blocks[block].begin;
+                newOrder[position] = m_order[position];
+                newBlockOf[m_order[position]] = firstNewBlocks[block];
+            }
+        }
+
+        scheduler.Run(chunks.size(), [&](size_t chunk) {
+            auto& [block, begin, end] = chunks[chunk];
+            auto& chunkSplit = m_chunkSplits[chunk];
+
+            for (uint32_t position = begin; position < end; ++position)
+            {
+                uint32_t localClass = m_localClasses[position];
+                newOrder[m_blocks[block].begin + chunkSplit.offsets[localClass]++] = m_order[position];
+                newBlockOf[m_order[position]] = firstNewBlocks[block] + chunkSplit.blockClasses[localClass];
+            }
+        });
+
+        m_order = std::move(newOrder);
+        m_blockOf = std::move(newBlockOf);
+        m_blocks = std::move(newBlocks);
+
+        return true;
+    }
+
+    [[nodiscard]] uint32_t GetNextBlock(uint32_t state, size_t input) const
+    {
+        uint32_t nextState = m_next[state * m_inputsCount + input];
+        return nextState == NO_STATE ? NO_STATE : m_blockOf[nextState];
+    }
+
+    // Numbers the given states by the blocks their transitions lead to, one input per pass.
+    // Classes are numbered in the order of their first state, like the parts of a block.
+    void ClassifyStates(const uint32_t* states, uint32_t* classes, size_t count) const
+    {
+        std::fill(classes, classes + count, 0);
+
+        for (size_t input = 0; input < m_inputsCount; ++input)
+        {
+            StatePairMap classMap(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                uint64_t key = StatePairMap::Pack(classes[i], GetNextBlock(states[i], input));
+                classes[i] = classMap.Insert(key, static_cast<uint32_t>(classMap.GetSize())).first;
+            }
+
+            // Distinct classes are already numbered by position, later inputs cannot change that.
+            if (classMap.GetSize() == count)
+            {
+                break;
+            }
+        }
+    }
+
+    void SplitChunk(const Chunk& chunk, ChunkSplit& chunkSplit)
+    {
+        uint32_t* localClasses = m_localClasses.data() + chunk.begin;
+        ClassifyStates(m_order.data() + chunk.begin, localClasses, chunk.end - chunk.begin);
+
+        for (uint32_t position = chunk.begin; position < chunk.end; ++position)
+        {
+            uint32_t localClass = m_localClasses[position];
+            if (localClass == chunkSplit.representatives.size())
+            {
+                chunkSplit.representatives.push_back(m_order[position]);
+                chunkSplit.classSizes.push_back(0);
+            }
+            ++chunkSplit.classSizes[localClass];
+        }
+    }
+
+    // Runs once all chunks of the block are split. Classes of the chunks are matched through
+    // their first states, then every chunk class gets the place its states are copied to.
+    void MergeBlockSplit(BlockSplit& blockSplit)
+    {
+        std::vector<uint32_t> representatives;
+        for (uint32_t chunk = blockSplit.firstChunk; chunk < blockSplit.firstChunk + blockSplit.chunksCount; ++chunk)
+        {
+            auto& chunkRepresentatives = m_chunkSplits[chunk].representatives;
+            representatives.insert(representatives.end(), chunkRepresentatives.begin(), chunkRepresentatives.end());
+        }
+
+        std::vector<uint32_t> blockClasses(representatives.size());
+        ClassifyStates(representatives.data(), blockClasses.data(), representatives.size());
+
+        std::vector<uint32_t> classSizes;
+        for (uint32_t chunk = blockSplit.firstChunk, i = 0; chunk < blockSplit.firstChunk + blockSplit.chunksCount; ++chunk)
+        {
+            auto& chunkSplit = m_chunkSplits[chunk];
+            chunkSplit.blockClasses.assign(blockClasses.begin() + i,
+                                           blockClasses.begin() + i + chunkSplit.representatives.size());
+            i += static_cast<uint32_t>(chunkSplit.representatives.size());
+
+            for (size_t localClass = 0; localClass < chunkSplit.blockClasses.size(); ++localClass)
+            {
+                uint32_t blockClass = chunkSplit.blockClasses[localClass];
+                if (blockClass == classSizes.size())
+                {
+                    classSizes.push_back(0);
+                }
+                classSizes[blockClass] += chunkSplit.classSizes[localClass];
+            }
+        }
+
+        blockSplit.classBegins.assign(classSizes.size() + 1, 0);
+        for (size_t blockClass = 0; blockClass < classSizes.size(); ++blockClass)
+        {
+            blockSplit.classBegins[blockClass + 1] = blockSplit.classBegins[blockClass] + classSizes[blockClass];
+        }
+
+        std::vector<uint32_t> cursors(blockSplit.classBegins.begin(), blockSplit.classBegins.end() - 1);
+        for (uint32_t chunk = blockSplit.firstChunk; chunk < blockSplit.firstChunk + blockSplit.chunksCount; ++chunk)
+        {
+            auto& chunkSplit = m_chunkSplits[chunk];
+            chunkSplit.offsets.resize(chunkSplit.blockClasses.size());
+
+            for (size_t localClass = 0; localClass < chunkSplit.blockClasses.size(); ++localClass)
+            {
+                uint32_t blockClass = chunkSplit.blockClasses[localClass];
+                chunkSplit.offsets[localClass] = cursors[blockClass];
+                cursors[blockClass] += chunkSplit.classSizes[localClass];
+            }
+        }
+    }
+
+    size_t m_statesCount;
+    size_t m_inputsCount;
+    uint32_t m_chunkStates;
+
+    std::vector<uint32_t> m_next;
+    std::vector<uint32_t> m_blockOf;
+    std::vector<uint32_t> m_order;
+    std::vector<BlockRange> m_blocks;
+
+    // Indexed by position in m_order, each chunk writes only its own positions.
+    std::vector<uint32_t> m_localClasses;
+    std::vector<ChunkSplit> m_chunkSplits;
+    std::unique_ptr<BlockSplit[]> m_blockSplits;
+};
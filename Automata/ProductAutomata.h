@@ -0,0 +1,191 @@
+#pragma once
+#include <cstdint>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "IndexedAutomata.h"
+#include "MooreAutomata.h"
+#include "StatePairMap.h"
+
+enum class ProductOperation
+{
+    Intersection,
+    Union,
+    Difference,
+};
+
+// Builds the reachable part of the product of two deterministic acceptors.
+// A missing transition leads to an implicit dead state, pairs that can no longer
+// accept anything are not materialized.
+class ProductAutomata
+{
+public:
+    static MooreAutomata Build(const MooreAutomata& left, const MooreAutomata& right, ProductOperation operation)
+    {
+        IndexedAutomata leftIndexed(left);
+        IndexedAutomata rightIndexed(right);
+
+        if (!leftIndexed.IsDeterministic() || !rightIndexed.IsDeterministic())
+        {
+            throw std::invalid_argument("Product requires deterministic automata");
+        }
+
+        ProductAutomata product(leftIndexed, rightIndexed, operation);
+        product.Explore();
+
+        return product.ToMooreAutomata();
+    }
+
+private:
+    static constexpr char PRODUCT_STATE_CHAR = 'P';
+
+    ProductAutomata(const IndexedAutomata& left, const IndexedAutomata& right, ProductOperation operation)
+        : m_left(left)
+        , m_right(right)
+        , m_operation(operation)
+        , m_leftDead(static_cast<uint32_t>(left.GetStatesCount()))
+        , m_rightDead(static_cast<uint32_t>(right.GetStatesCount()))
+        , m_pairIndexes(left.GetStatesCount() + right.GetStatesCount())
+    {
+        std::set<std::string> inputs(left.GetInputs().begin(), left.GetInputs().end());
+        inputs.insert(right.GetInputs().begin(), right.GetInputs().end());
+
+        for (auto& input: inputs)
+        {
+            m_inputs.push_back(input);
+            m_leftInputs.push_back(left.GetInputIndex(input));
+            m_rightInputs.push_back(right.GetInputIndex(input));
+        }
+    }
+
+    void Explore()
+    {
+        AddPair(m_left.GetStartState(), m_right.GetStartState());
+
+        for (size_t index = 0; index < m_pairs.size(); ++index)
+        {
+            auto [leftState, rightState] = StatePairMap::Unpack(m_pairs[index]);
+
+            for (size_t input = 0; input < m_inputs.size(); ++input)
+            {
+                uint32_t leftNext = GetNextState(m_left, leftState, m_leftInputs[input], m_leftDead);
+                uint32_t rightNext = GetNextState(m_right, rightState, m_rightInputs[input], m_rightDead);
+
+                m_transitions.push_back(IsDeadPair(leftNext, rightNext)
+                                        ? IndexedAutomata::NO_STATE
+                                        : AddPair(leftNext, rightNext));
+            }
+        }
+    }
+
+    uint32_t AddPair(uint32_t leftState, uint32_t rightState)
+    {
+        uint64_t key = StatePairMap::Pack(leftState, rightState);
+        auto [index, isInserted] = m_pairIndexes.Insert(key, static_cast<uint32_t>(m_pairs.size()));
+
+        if (isInserted)
+        {
+            m_pairs.push_back(key);
+        }
+
+        return index;
+    }
+
+    static uint32_t GetNextState(const IndexedAutomata& automata, uint32_t state, uint32_t input, uint32_t dead)
+    {
+        if (state == dead || input == IndexedAutomata::NO_INPUT)
+        {
+            return dead;
+        }
+
+        uint32_t nextState = automata.GetNextState(state, input);
+        return nextState == IndexedAutomata::NO_STATE ? dead : nextState;
+    }
+
+    [[nodiscard]] bool IsDeadPair(uint32_t leftState, uint32_t rightState) const
+    {
+        switch (m_operation)
+        {
+            case ProductOperation::Intersection:
+                return leftState == m_leftDead || rightState == m_rightDead;
+            case ProductOperation::Union:
+                return leftState == m_leftDead && rightState == m_rightDead;
+            case ProductOperation::Difference:
+                return leftState == m_leftDead;
+        }
+
+        return false;
+    }
+
+    [[nodiscard]] bool IsFinalPair(uint32_t leftState, uint32_t rightState) const
+    {
+        bool isLeftFinal = leftState != m_leftDead && m_left.IsFinalState(leftState);
+        bool isRightFinal = rightState != m_rightDead && m_right.IsFinalState(rightState);
+
+        switch (m_operation)
+        {
+            case ProductOperation::Intersection:
+                return isLeftFinal && isRightFinal;
+            case ProductOperation::Union:
+                return isLeftFinal || isRightFinal;
+            case ProductOperation::Difference:
+                return isLeftFinal && !isRightFinal;
+        }
+
+        return false;
+    }
+
+    MooreAutomata ToMooreAutomata() const
+    {
+        std::vector<std::string> names;
+        names.reserve(m_pairs.size());
+        for (size_t index = 0; index < m_pairs.size(); ++index)
+        {
+            names.push_back(PRODUCT_STATE_CHAR + std::to_string(index));
+        }
+
+        std::set<std::string> states;
+        std::set<std::string> finalStates;
+        Transitions transitions;
+
+        for (size_t index = 0; index < m_pairs.size(); ++index)
+        {
+            auto [leftState, rightState] = StatePairMap::Unpack(m_pairs[index]);
+
+            states.insert(names[index]);
+            if (IsFinalPair(leftState, rightState))
+            {
+                finalStates.insert(names[index]);
+            }
+
+            auto& stateTransitions = transitions[names[index]];
+            for (size_t input = 0; input < m_inputs.size(); ++input)
+            {
+                uint32_t nextState = m_transitions[index * m_inputs.size() + input];
+                if (nextState != IndexedAutomata::NO_STATE)
+                {
+                    stateTransitions.emplace(m_inputs[input], Transition(m_inputs[input], names[nextState]));
+                }
+            }
+        }
+
+        return {std::set<std::string>(m_inputs.begin(), m_inputs.end()), states, transitions,
+                names.front(), finalStates};
+    }
+
+    const IndexedAutomata& m_left;
+    const IndexedAutomata& m_right;
+    ProductOperation m_operation;
+    uint32_t m_leftDead;
+    uint32_t m_rightDead;
+
+    std::vector<std::string> m_inputs;
+    std::vector<uint32_t> m_leftInputs;
+    std::vector<uint32_t> m_rightInputs;
+
+    StatePairMap m_pairIndexes;
+    std::vector<uint64_t> m_pairs;
+    std::vector<uint32_t> m_transitions;
+};
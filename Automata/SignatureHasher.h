@@ -0,0 +1,148 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MIM_SIGNATURE_X86 1
+#include <immintrin.h>
+#endif
+
+enum class SignatureKernel
+{
+    Scalar,
+    Avx2,
+    Avx512,
+};
+
+// Hashes the refinement signature of every state: its own block and the block of its
+// successor on each input. The transition table is dense and input-major, next[input * statesCount + state].
+// All kernels produce the same hashes, the vector ones gather the successor blocks 8 or 16 states at a time.
+class SignatureHasher
+{
+public:
+    static SignatureKernel GetBestKernel()
+    {
+        static const SignatureKernel kernel = IsKernelSupported(SignatureKernel::Avx512) ? SignatureKernel::Avx512
+                                              : IsKernelSupported(SignatureKernel::Avx2) ? SignatureKernel::Avx2
+                                              : SignatureKernel::Scalar;
+        return kernel;
+    }
+
+    static bool IsKernelSupported(SignatureKernel kernel)
+    {
+        switch (kernel)
+        {
+            case SignatureKernel::Scalar:
+                return true;
+#ifdef MIM_SIGNATURE_X86
+            case SignatureKernel::Avx2:
+                return __builtin_cpu_supports("avx2");
+            case SignatureKernel::Avx512:
+                return __builtin_cpu_supports("avx512f");
+#endif
+            default:
+                return false;
+        }
+    }
+
+    static void Compute(SignatureKernel kernel, const int* partition, const uint32_t* next,
+                        size_t statesCount, size_t inputsCount, uint32_t* hashes)
+    {
+        size_t done = 0;
+
+#ifdef MIM_SIGNATURE_X86
+        if (kernel == SignatureKernel::Avx512)
+        {
+            done = ComputeAvx512(partition, next, statesCount, inputsCount, hashes);
+        }
+        else if (kernel == SignatureKernel::Avx2)
+        {
+            done = ComputeAvx2(partition, next, statesCount, inputsCount, hashes);
+        }
+#endif
+
+        ComputeScalar(partition, next, statesCount, inputsCount, hashes, done);
+    }
+
+private:
+    static constexpr uint32_t HASH_SEED = 0x811C9DC5u;
+    static constexpr uint32_t HASH_PRIME = 0x01000193u;
+
+    static uint32_t Finalize(uint32_t hash)
+    {
+        return hash ^ (hash >> 15);
+    }
+
+    static void ComputeScalar(const int* partition, const uint32_t* next, size_t statesCount, size_t inputsCount,
+                              uint32_t* hashes, size_t firstState)
+    {
+        for (size_t state = firstState; state < statesCount; ++state)
+        {
+            uint32_t hash = (HASH_SEED ^ static_cast<uint32_t>(partition[state])) * HASH_PRIME;
+            for (size_t input = 0; input < inputsCount; ++input)
+            {
+                auto block = static_cast<uint32_t>(partition[next[input * statesCount + state]]);
+                hash = (hash ^ block) * HASH_PRIME;
+            }
+            hashes[state] = Finalize(hash);
+        }
+    }
+
+#ifdef MIM_SIGNATURE_X86
+    // Both vector kernels return how many leading states they hashed, the scalar loop finishes the tail.
+
+    __attribute__((target("avx2")))
+    static size_t ComputeAvx2(const int* partition, const uint32_t* next, size_t statesCount, size_t inputsCount,
+                              uint32_t* hashes)
+    {
+        const __m256i seed = _mm256_set1_epi32(static_cast<int>(HASH_SEED));
+        const __m256i prime = _mm256_set1_epi32(static_cast<int>(HASH_PRIME));
+        size_t state = 0;
+
+        for (; state + 8 <= statesCount; state += 8)
+        {
+            __m256i own = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(partition + state));
+            __m256i hash = _mm256_mullo_epi32(_mm256_xor_si256(seed, own), prime);
+
+            for (size_t input = 0; input < inputsCount; ++input)
+            {
+                __m256i indexes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(next + input * statesCount + state));
+                __m256i blocks = _mm256_i32gather_epi32(partition, indexes, 4);
+                hash = _mm256_mullo_epi32(_mm256_xor_si256(hash, blocks), prime);
+            }
+
+            hash = _mm256_xor_si256(hash, _mm256_srli_epi32(hash, 15));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(hashes + state), hash);
+        }
+
+        return state;
+    }
+
+    __attribute__((target("avx512f")))
+    static size_t ComputeAvx512(const int* partition, const uint32_t* next, size_t statesCount, size_t inputsCount,
+                                uint32_t* hashes)
+    {
+        const __m512i seed = _mm512_set1_epi32(static_cast<int>(HASH_SEED));
+        const __m512i prime = _mm512_set1_epi32(static_cast<int>(HASH_PRIME));
+        size_t state = 0;
+
+        for (; state + 16 <= statesCount; state += 16)
+        {
+            __m512i own = _mm512_loadu_si512(partition + state);
+            __m512i hash = _mm512_mullo_epi32(_mm512_xor_si512(seed, own), prime);
+
+            for (size_t input = 0; input < inputsCount; ++input)
+            {
+                __m512i indexes = _mm512_loadu_si512(next + input * statesCount + state);
+                __m512i blocks = _mm512_i32gather_epi32(indexes, partition, 4);
+                hash = _mm512_mullo_epi32(_mm512_xor_si512(hash, blocks), prime);
+            }
+
+            hash = _mm512_xor_si512(hash, _mm512_srli_epi32(hash, 15));
+            _mm512_storeu_si512(hashes + state, hash);
+        }
+
+        return state;
+    }
+#endif
+};
@@ -0,0 +1,225 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+// Partition refinement for automata with at most 64 states: tables live in fixed-size
+// arrays and every block is a 64-bit mask of its states, so nothing is allocated.
+template <size_t MaxStates, size_t MaxInputs>
+class SmallMinimizer
+{
+    static_assert(MaxStates <= 64, "A block must fit into a 64-bit mask");
+    static_assert(MaxStates <= 256 && MaxInputs <= 256, "States and inputs are stored as uint8_t");
+
+public:
+    using StateMask = uint64_t;
+
+    static constexpr size_t MAX_STATES = MaxStates;
+    static constexpr size_t MAX_INPUTS = MaxInputs;
+
+    explicit SmallMinimizer(size_t inputsCount)
+        : m_inputsCount(inputsCount)
+    {
+    }
+
+    static bool Fits(size_t statesCount, size_t inputsCount)
+    {
+        return statesCount > 0 && statesCount <= MaxStates && inputsCount <= MaxInputs;
+    }
+
+    void SetTransition(size_t input, size_t state, size_t nextState)
+    {
+        m_next[input][state] = static_cast<uint8_t>(nextState);
+        m_predecessors[input][nextState] |= StateMask(1) << state;
+    }
+
+    // States with different initial classes are never merged, classes are below MaxStates.
+    void SetInitialClass(size_t state, size_t initialClass)
+    {
+        m_initialClasses[state] = static_cast<uint8_t>(initialClass);
+    }
+
+    [[nodiscard]] StateMask GetReachableStates(size_t startState) const
+    {
+        StateMask reachable = StateMask(1) << startState;
+        StateMask frontier = reachable;
+
+        while (frontier != 0)
+        {
+            size_t state = std::countr_zero(frontier);
+            frontier &= frontier - 1;
+
+            for (size_t input = 0; input < m_inputsCount; ++input)
+            {
+                StateMask next = StateMask(1) << m_next[input][state];
+                frontier |= next & ~reachable;
+                reachable |= next;
+            }
+        }
+
+        return reachable;
+    }
+
+    // Refines the initial classes of the given states until every block is stable
+    // under every input. Fills the block of each state and returns the blocks count.
+    size_t Minimize(StateMask states, std::array<uint8_t, MaxStates>& blockOf) const
+    {
+        std::array<StateMask, MaxStates> blocks {};
+        size_t blocksCount = 0;
+
+        for (StateMask rest = states; rest != 0; )
+        {
+            size_t state = std::countr_zero(rest);
+            StateMask block = 0;
+
+            for (StateMask candidates = rest; candidates != 0; candidates &= candidates - 1)
+            {
+                size_t candidate = std::countr_zero(candidates);
+                if (m_initialClasses[candidate] == m_initialClasses[state])
+                {
+                    block |= StateMask(1) << candidate;
+                }
+            }
+
+            blocks[blocksCount++] = block;
+            rest &= ~block;
+        }
+
+        bool isChanged = true;
+        while (isChanged)
+        {
+            isChanged = false;
+
+            for (size_t splitter = 0; splitter < blocksCount; ++splitter)
+            {
+                for (size_t input = 0; input < m_inputsCount; ++input)
+                {
+                    StateMask predecessors = 0;
+                    for (StateMask targets = blocks[splitter]; targets != 0; targets &= targets - 1)
+                    {
+                        predecessors |= m_predecessors[input][std::countr_zero(targets)];
+                    }
+
+                    for (size_t block = 0; block < blocksCount; ++block)
+                    {
+                        StateMask inside = blocks[block] & predecessors;
+                        if (inside != 0 && inside != blocks[block])
+                        {
+                            blocks[blocksCount++] = blocks[block] & ~predecessors;
+                            blocks[block] = inside;
+                            isChanged = true;
+                        }
+                    }
+                }
+            }
+        }
+
+        for (size_t block = 0; block < blocksCount; ++block)
+        {
+            for (StateMask members = blocks[block]; members != 0; members &= members - 1)
+            {
+                blockOf[std::countr_zero(members)] = static_cast<uint8_t>(block);
+            }
+        }
+
+        return blocksCount;
+    }
+
+    // Same blocks as Minimize, found by Moore rounds: every round splits each block by the
+    // blocks of the previous round its states move to. Blocks are numbered in the order the
+    // rounds produce them, the parts of a block follow each other ordered by their lowest state.
+    size_t MinimizeInRounds(StateMask states, std::array<uint8_t, MaxStates>& blockOf) const
+    {
+        std::array<StateMask, MaxStates> blocks {};
+        size_t blocksCount = 0;
+
+        for (StateMask rest = states; rest != 0; )
+        {
+            size_t state = std::countr_zero(rest);
+            StateMask block = 0;
+
+            for (StateMask candidates = rest; candidates != 0; candidates &= candidates - 1)
+            {
+                size_t candidate = std::countr_zero(candidates);
+                if (m_initialClasses[candidate] == m_initialClasses[state])
+                {
+                    block |= StateMask(1) << candidate;
+                }
+            }
+
+            blockOf[state] = static_cast<uint8_t>(blocksCount);
+            blocks[blocksCount++] = block;
+            rest &= ~block;
+        }
+        SetBlocks(blocks, blocksCount, blockOf);
+
+        while (true)
+        {
+            std::array<StateMask, MaxStates> newBlocks {};
+            size_t newBlocksCount = 0;
+
+            for (size_t block = 0; block < blocksCount; ++block)
+            {
+                for (StateMask rest = blocks[block]; rest != 0; )
+                {
+                    size_t state = std::countr_zero(rest);
+                    StateMask part = 0;
+
+                    for (StateMask candidates = rest; candidates != 0; candidates &= candidates - 1)
+                    {
+                        size_t candidate = std::countr_zero(candidates);
+                        if (HasSameNextBlocks(state, candidate, blockOf))
+                        {
+                            part |= StateMask(1) << candidate;
+                        }
+                    }
+
+                    newBlocks[newBlocksCount++] = part;
+                    rest &= ~part;
+                }
+            }
+
+            if (newBlocksCount == blocksCount)
+            {
+                return blocksCount;
+            }
+
+            blocks = newBlocks;
+            blocksCount = newBlocksCount;
+            SetBlocks(blocks, blocksCount, blockOf);
+        }
+    }
+
+private:
+    static void SetBlocks(const std::array<StateMask, MaxStates>& blocks, size_t blocksCount,
+                          std::array<uint8_t, MaxStates>& blockOf)
+    {
+        for (size_t block = 0; block < blocksCount; ++block)
+        {
+            for (StateMask members = blocks[block]; members != 0; members &= members - 1)
+            {
+                blockOf[std::countr_zero(members)] = static_cast<uint8_t>(block);
+            }
+        }
+    }
+
+    [[nodiscard]] bool HasSameNextBlocks(size_t first, size_t second, const std::array<uint8_t, MaxStates>& blockOf) const
+    {
+        for (size_t input = 0; input < m_inputsCount; ++input)
+        {
+            if (blockOf[m_next[input][first]] != blockOf[m_next[input][second]])
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    size_t m_inputsCount;
+
+    std::array<std::array<uint8_t, MaxStates>, MaxInputs> m_next {};
+    std::array<std::array<StateMask, MaxStates>, MaxInputs> m_predecessors {};
+    std::array<uint8_t, MaxStates> m_initialClasses {};
+};
@@ -0,0 +1,108 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Open-addressing hash map from a packed (uint32, uint32) state pair to a uint32 index.
+class StatePairMap
+{
+public:
+    static constexpr uint32_t NOT_FOUND = std::numeric_limits<uint32_t>::max();
+
+    explicit StatePairMap(size_t expectedSize = 16)
+    {
+        Rehash(GetCapacityFor(expectedSize));
+    }
+
+    static uint64_t Pack(uint32_t first, uint32_t second)
+    {
+        return (static_cast<uint64_t>(first) << 32) | second;
+    }
+
+    static std::pair<uint32_t, uint32_t> Unpack(uint64_t key)
+    {
+        return {static_cast<uint32_t>(key >> 32), static_cast<uint32_t>(key)};
+    }
+
+    // Returns the stored value and whether the key was inserted by this call.
+    std::pair<uint32_t, bool> Insert(uint64_t key, uint32_t value)
+    {
+        if ((m_size + 1) * 4 > m_keys.size() * 3)
+        {
+            Rehash(m_keys.size() * 2);
+        }
+
+        size_t slot = FindSlot(key);
+        if (m_keys[slot] == key)
+        {
+            return {m_values[slot], false};
+        }
+
+        m_keys[slot] = key;
+        m_values[slot] = value;
+        ++m_size;
+
+        return {value, true};
+    }
+
+    [[nodiscard]] uint32_t Find(uint64_t key) const
+    {
+        size_t slot = FindSlot(key);
+        return m_keys[slot] == key ? m_values[slot] : NOT_FOUND;
+    }
+
+    [[nodiscard]] size_t GetSize() const
+    {
+        return m_size;
+    }
+
+private:
+    static constexpr uint64_t EMPTY_KEY = std::numeric_limits<uint64_t>::max();
+
+    static size_t GetCapacityFor(size_t size)
+    {
+        size_t capacity = 16;
+        while (capacity * 3 < size * 4)
+        {
+            capacity *= 2;
+        }
+
+        return capacity;
+    }
+
+    [[nodiscard]] size_t FindSlot(uint64_t key) const
+    {
+        size_t mask = m_keys.size() - 1;
+        size_t slot = (key * 0x9E3779B97F4A7C15ull) >> 32 & mask;
+
+        while (m_keys[slot] != key && m_keys[slot] != EMPTY_KEY)
+        {
+            slot = (slot + 1) & mask;
+        }
+
+        return slot;
+    }
+
+    void Rehash(size_t capacity)
+    {
+        std::vector<uint64_t> keys(capacity, EMPTY_KEY);
+        std::vector<uint32_t> values(capacity);
+        std::swap(keys, m_keys);
+        std::swap(values, m_values);
+
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            if (keys[i] != EMPTY_KEY)
+            {
+                size_t slot = FindSlot(keys[i]);
+                m_keys[slot] = keys[i];
+                m_values[slot] = values[i];
+            }
+        }
+    }
+
+    std::vector<uint64_t> m_keys;
+    std::vector<uint32_t> m_values;
+    size_t m_size = 0;
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include <set>
 #include <string>
+#include <utility>
 
 class Transition
 {
@@ -24,6 +25,15 @@ public:
         m_nextStates.insert(state);
     }
 
+    // Keeps only the first next state under the new name, its set node is reused.
+    void RenameFirstState(const std::string& state)
+    {
+        auto node = m_nextStates.extract(m_nextStates.begin());
+        m_nextStates.clear();
+        node.value() = state;
+        m_nextStates.insert(std::move(node));
+    }
+
     [[nodiscard]] std::string GetFirstState() const
     {
         if (m_nextStates.empty())
@@ -50,7 +60,7 @@ public:
         return states;
     }
 
-    [[nodiscard]] std::set<std::string> GetStates() const
+    [[nodiscard]] const std::set<std::string>& GetStates() const
     {
         return m_nextStates;
     }
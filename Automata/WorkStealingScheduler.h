@@ -0,0 +1,253 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs batches of independent tasks on a fixed set of threads. Every worker owns a range
+// of task indexes and takes tasks from its front, a worker whose range is empty steals the
+// back half of another range, so a few long tasks do not leave the other threads idle.
+// Ranges are single atomic words, taking and stealing never lock. Workers join a batch
+// only while it is open and Run returns after the last one left, so batches never overlap.
+class WorkStealingScheduler
+{
+public:
+    explicit WorkStealingScheduler(size_t threadsCount)
+        : m_ranges(std::max<size_t>(threadsCount, 1))
+    {
+        for (size_t worker = 1; worker < m_ranges.size(); ++worker)
+        {
+            m_threads.emplace_back([this, worker] { RunWorker(worker); });
+        }
+    }
+
+    WorkStealingScheduler(const WorkStealingScheduler&) = delete;
+    WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+
+    ~WorkStealingScheduler()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_isStopped = true;
+        }
+        m_batchStarted.notify_all();
+
+        for (auto& thread: m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    [[nodiscard]] size_t GetThreadsCount() const
+    {
+        return m_ranges.size();
+    }
+
+    // Calls task(index) for every index below tasksCount, the calling thread works as one
+    // of the workers. Returns once every task is done, rethrows the first exception thrown.
+    void Run(size_t tasksCount, const std::function<void(size_t)>& task)
+    {
+        if (tasksCount == 0)
+        {
+            return;
+        }
+
+        if (m_threads.empty() || tasksCount == 1)
+        {
+            for (size_t index = 0; index < tasksCount; ++index)
+            {
+                task(index);
+            }
+            return;
+        }
+
+        m_exception = nullptr;
+        m_task.store(&task, std::memory_order_relaxed);
+
+        size_t workersCount = m_ranges.size();
+        for (size_t worker = 0; worker < workersCount; ++worker)
+        {
+            m_ranges[worker].value.store(Pack(tasksCount * worker / workersCount,
+                                              tasksCount * (worker + 1) / workersCount),
+                                         std::memory_order_release);
+        }
+
+        {
+            std::lock_guard lock(m_mutex);
+            ++m_batch;
+            m_isBatchOpen = true;
+        }
+        m_batchStarted.notify_all();
+
+        RunTasks(0);
+
+        // A worker leaves only when it finds every range empty and has run the tasks it
+        // took, so once nobody is left every task is done and the ranges can be reused.
+        {
+            std::unique_lock lock(m_mutex);
+            m_isBatchOpen = false;
+            m_batchFinished.wait(lock, [&] { return m_activeWorkers == 0; });
+        }
+
+        if (m_exception)
+        {
+            std::rethrow_exception(m_exception);
+        }
+    }
+
+private:
+    static constexpr uint64_t EMPTY_RANGE = 0;
+
+    // Own cache line per range, otherwise taking a task would keep invalidating the neighbours.
+    struct alignas(64) Range
+    {
+        std::atomic<uint64_t> value {EMPTY_RANGE};
+    };
+
+    static uint64_t Pack(size_t begin, size_t end)
+    {
+        return (static_cast<uint64_t>(begin) << 32) | end;
+    }
+
+    static size_t GetBegin(uint64_t range)
+    {
+        return static_cast<size_t>(range >> 32);
+    }
+
+    static size_t GetEnd(uint64_t range)
+    {
+        return static_cast<size_t>(range & 0xFFFFFFFFu);
+    }
+
+    void RunWorker(size_t worker)
+    {
+        uint64_t batch = 0;
+
+        while (true)
+        {
+            {
+                std::unique_lock lock(m_mutex);
+                m_batchStarted.wait(lock, [&] { return m_isStopped || (m_isBatchOpen && m_batch != batch); });
+                if (m_isStopped)
+                {
+                    return;
+                }
+                batch = m_batch;
+                ++m_activeWorkers;
+            }
+
+            RunTasks(worker);
+
+            {
+                std::lock_guard lock(m_mutex);
+                --m_activeWorkers;
+            }
+            m_batchFinished.notify_one();
+        }
+    }
+
+    void RunTasks(size_t worker)
+    {
+        size_t index = 0;
+        uint64_t ownRange = EMPTY_RANGE;
+        while (TakeTask(worker, index, ownRange) || StealTask(worker, ownRange, index))
+        {
+            RunTask(index);
+        }
+    }
+
+    void RunTask(size_t index)
+    {
+        try
+        {
+            (*m_task.load(std::memory_order_acquire))(index);
+        }
+        catch (...)
+        {
+            std::lock_guard lock(m_mutex);
+            if (!m_exception)
+            {
+                m_exception = std::current_exception();
+            }
+        }
+    }
+
+    // Leaves the empty value of the range in current when there is nothing to take.
+    bool TakeTask(size_t worker, size_t& index, uint64_t& current)
+    {
+        auto& range = m_ranges[worker].value;
+        current = range.load(std::memory_order_acquire);
+
+        while (GetBegin(current) < GetEnd(current))
+        {
+            if (range.compare_exchange_weak(current, Pack(GetBegin(current) + 1, GetEnd(current)),
+                                            std::memory_order_acq_rel))
+            {
+                index = GetBegin(current);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Within a batch a taken index never comes back into any range, so a range value is never
+    // seen twice and the exchanges below cannot be fooled by a range that emptied and refilled.
+    // Only the owner refills its empty range, the rest of the stolen half goes there by an
+    // exchange from the empty value the owner saw, never by a plain store.
+    bool StealTask(size_t worker, uint64_t ownRange, size_t& index)
+    {
+        size_t workersCount = m_ranges.size();
+
+        for (size_t offset = 1; offset < workersCount; ++offset)
+        {
+            auto& victim = m_ranges[(worker + offset) % workersCount].value;
+            uint64_t current = victim.load(std::memory_order_acquire);
+
+            while (GetBegin(current) < GetEnd(current))
+            {
+                size_t begin = GetBegin(current);
+                size_t end = GetEnd(current);
+                size_t middle = begin + (end - begin) / 2;
+
+                if (victim.compare_exchange_weak(current, Pack(begin, middle), std::memory_order_acq_rel))
+                {
+                    index = middle;
+                    if (middle + 1 < end
+                        && !m_ranges[worker].value.compare_exchange_strong(ownRange, Pack(middle + 1, end),
+                                                                           std::memory_order_acq_rel))
+                    {
+                        // Cannot happen while batches do not overlap, the tasks are run here rather than lost.
+                        for (size_t rest = middle + 1; rest < end; ++rest)
+                        {
+                            RunTask(rest);
+                        }
+                    }
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    std::vector<Range> m_ranges;
+    std::vector<std::thread> m_threads;
+
+    std::atomic<const std::function<void(size_t)>*> m_task {nullptr};
+    std::exception_ptr m_exception;
+
+    std::mutex m_mutex;
+    std::condition_variable m_batchStarted;
+    std::condition_variable m_batchFinished;
+    uint64_t m_batch = 0;
+    size_t m_activeWorkers = 0;
+    bool m_isBatchOpen = false;
+    bool m_isStopped = false;
+};
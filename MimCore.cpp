@@ -0,0 +1,58 @@
+#include "MimCore.h"
+
+#include "Automata/MealyAutomata.h"
+#include "Automata/MooreAutomata.h"
+
+AutomataType MimCore::ParseAutomataType(const std::string& name)
+{
+    if (name == "mealy")
+    {
+        return AutomataType::Mealy;
+    }
+    if (name == "moore")
+    {
+        return AutomataType::Moore;
+    }
+
+    throw std::invalid_argument("Invalid automaton type: " + name);
+}
+
+std::unique_ptr<IAutomata> MimCore::CreateAutomata(AutomataType type, size_t threadsCount)
+{
+    if (type == AutomataType::Mealy)
+    {
+        return std::make_unique<MealyAutomata>();
+    }
+
+    auto automata = std::make_unique<MooreAutomata>();
+    automata->SetParallelRefinement(threadsCount);
+    return automata;
+}
+
+namespace
+{
+// Reads the caller's table in place instead of copying it into an istringstream.
+class ViewBuffer final : public std::streambuf
+{
+public:
+    explicit ViewBuffer(std::string_view view)
+    {
+        char* data = const_cast<char*>(view.data());
+        setg(data, data, data + view.size());
+    }
+};
+}
+
+std::string MimCore::Minimize(AutomataType type, std::string_view table, size_t threadsCount)
+{
+    ViewBuffer buffer(table);
+    std::istream input(&buffer);
+    std::ostringstream output;
+
+    auto automata = CreateAutomata(type, threadsCount);
+    automata->ReadFromStream(input);
+    automata->Minimize();
+    automata->PrintToStream(output);
+
+    return output.str();
+}
@@ -0,0 +1,32 @@
+#ifndef MIM_MIMCORE_H
+#define MIM_MIMCORE_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+class IAutomata;
+
+enum class AutomataType
+{
+    Mealy,
+    Moore,
+};
+
+// In-process entry point of the minimizer for embedding: tables are taken and returned
+// as text in the same CSV format the mim command reads and writes, nothing touches the
+// filesystem. Malformed tables are reported with std::invalid_argument.
+class MimCore
+{
+public:
+    // Accepts the command names of the CLI, "mealy" and "moore".
+    static AutomataType ParseAutomataType(const std::string& name);
+
+    // threadsCount bounds the threads one minimization may use, only the refinement of big
+    // Moore tables runs in parallel.
+    static std::unique_ptr<IAutomata> CreateAutomata(AutomataType type, size_t threadsCount = 1);
+
+    static std::string Minimize(AutomataType type, std::string_view table, size_t threadsCount = 1);
+};
+
+#endif //MIM_MIMCORE_H
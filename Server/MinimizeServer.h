@@ -0,0 +1,466 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../MimCore.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// Byte stream carrying frames in both directions.
+class FrameChannel
+{
+public:
+    // Reads exactly size bytes, returns false when the stream ends first.
+    virtual bool Read(char* data, size_t size) = 0;
+    virtual void Write(const char* data, size_t size) = 0;
+    virtual ~FrameChannel() = default;
+};
+
+class FileChannel final : public FrameChannel
+{
+public:
+    FileChannel(FILE* input, FILE* output)
+        : m_input(input)
+        , m_output(output)
+    {
+#ifdef _WIN32
+        _setmode(_fileno(input), _O_BINARY);
+        _setmode(_fileno(output), _O_BINARY);
+#endif
+    }
+
+    bool Read(char* data, size_t size) override
+    {
+        return std::fread(data, 1, size, m_input) == size;
+    }
+
+    void Write(const char* data, size_t size) override
+    {
+        if (std::fwrite(data, 1, size, m_output) != size || std::fflush(m_output) != 0)
+        {
+            throw std::runtime_error("Could not write response");
+        }
+    }
+
+private:
+    FILE* m_input;
+    FILE* m_output;
+};
+
+#ifndef _WIN32
+class SocketChannel final : public FrameChannel
+{
+public:
+    explicit SocketChannel(int socket)
+        : m_socket(socket)
+    {
+    }
+
+    ~SocketChannel() override
+    {
+        close(m_socket);
+    }
+
+    bool Read(char* data, size_t size) override
+    {
+        while (size > 0)
+        {
+            ssize_t received = recv(m_socket, data, size, 0);
+            if (received <= 0)
+            {
+                return false;
+            }
+            data += received;
+            size -= received;
+        }
+
+        return true;
+    }
+
+    void Write(const char* data, size_t size) override
+    {
+        while (size > 0)
+        {
+            ssize_t sent = send(m_socket, data, size, MSG_NOSIGNAL);
+            if (sent <= 0)
+            {
+                throw std::runtime_error("Could not write response");
+            }
+            data += sent;
+            size -= sent;
+        }
+    }
+
+private:
+    int m_socket;
+};
+#endif
+
+class WorkerPool
+{
+public:
+    explicit WorkerPool(size_t threadsCount)
+    {
+        for (size_t i = 0; i < std::max<size_t>(threadsCount, 1); ++i)
+        {
+            m_threads.emplace_back([this] { Run(); });
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_isStopped = true;
+        }
+        m_hasTasks.notify_all();
+
+        for (auto& thread: m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    void Submit(std::function<void()> task)
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_tasks.push(std::move(task));
+        }
+        m_hasTasks.notify_one();
+    }
+
+    // Blocks until every submitted task has finished.
+    void Wait()
+    {
+        std::unique_lock lock(m_mutex);
+        m_isIdle.wait(lock, [this] { return m_tasks.empty() && m_activeCount == 0; });
+    }
+
+private:
+    void Run()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock lock(m_mutex);
+                m_hasTasks.wait(lock, [this] { return m_isStopped || !m_tasks.empty(); });
+                if (m_tasks.empty())
+                {
+                    return;
+                }
+
+                task = std::move(m_tasks.front());
+                m_tasks.pop();
+                ++m_activeCount;
+            }
+
+            task();
+
+            {
+                std::lock_guard lock(m_mutex);
+                --m_activeCount;
+            }
+            m_isIdle.notify_all();
+        }
+    }
+
+    std::vector<std::thread> m_threads;
+    std::queue<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_hasTasks;
+    std::condition_variable m_isIdle;
+    size_t m_activeCount = 0;
+    bool m_isStopped = false;
+};
+
+// Keeps a warm process that minimizes tables sent as frames:
+//   request:  uint32 id, uint8 type (0 - mealy, 1 - moore), uint32 length, table
+//   response: uint32 id, uint8 status (0 - ok, 1 - error), uint32 length, table or error message
+// Integers are little-endian. Requests of one client are processed concurrently and
+// answered in completion order, the id pairs a response with its request. A client with
+// PENDING_REQUESTS_PER_WORKER unanswered requests per worker is not read from until one of
+// them is answered, so one client can keep every worker busy. Payloads are read into buffers
+// the connection reuses, there are no more of them than pending requests, so a client holds
+// at most that many times MAX_PAYLOAD_SIZE bytes. Every request is minimized on at most
+// threadsPerRequest threads, the workers already keep the cores busy.
+class MinimizeServer
+{
+public:
+    static constexpr uint32_t MAX_PAYLOAD_SIZE = 256u << 20;
+    static constexpr size_t PENDING_REQUESTS_PER_WORKER = 2;
+
+    explicit MinimizeServer(size_t workersCount, size_t threadsPerRequest = 1)
+        : m_workers(workersCount)
+        , m_maxPendingRequests(PENDING_REQUESTS_PER_WORKER * std::max<size_t>(workersCount, 1))
+        , m_threadsPerRequest(threadsPerRequest)
+    {
+    }
+
+    // Serves one client until the input ends, then waits for the pending answers.
+    void ServeStream(FILE* input, FILE* output)
+    {
+        ServeConnection(std::make_shared<Connection>(std::make_unique<FileChannel>(input, output)));
+        m_workers.Wait();
+    }
+
+    void ServeSocket(const std::string& path)
+    {
+#ifdef _WIN32
+        throw std::runtime_error("Unix domain sockets are not supported on this platform, serve over stdin instead");
+#else
+        sockaddr_un address {};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path))
+        {
+            throw std::invalid_argument("Socket path is too long: " + path);
+        }
+        path.copy(address.sun_path, path.size());
+
+        int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        unlink(path.c_str());
+        if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(listener, SOMAXCONN) != 0)
+        {
+            throw std::runtime_error("Could not listen on socket " + path);
+        }
+
+        std::vector<ClientThread> clients;
+        while (true)
+        {
+            int client = accept(listener, nullptr, nullptr);
+            if (client < 0)
+            {
+                if (errno == EINTR || errno == ECONNABORTED)
+                {
+                    continue;
+                }
+                if (errno == EMFILE || errno == ENFILE)
+                {
+                    // Out of descriptors until some client leaves, retrying at once would only spin.
+                    JoinFinishedClients(clients);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                    continue;
+                }
+                break;
+            }
+
+            JoinFinishedClients(clients);
+            auto connection = std::make_shared<Connection>(std::make_unique<SocketChannel>(client));
+            auto isFinished = std::make_shared<std::atomic<bool>>(false);
+            clients.push_back({std::thread([this, connection, isFinished] {
+                ServeConnection(connection);
+                isFinished->store(true, std::memory_order_release);
+            }), isFinished});
+        }
+
+        // The clients already connected are served to the end before the error is reported.
+        int error = errno;
+        close(listener);
+        for (auto& client: clients)
+        {
+            client.thread.join();
+        }
+        throw std::runtime_error("Could not accept connections on socket " + path + ": " + std::strerror(error));
+#endif
+    }
+
+private:
+    enum Status : uint8_t
+    {
+        STATUS_OK = 0,
+        STATUS_ERROR = 1,
+    };
+
+    static constexpr size_t HEADER_SIZE = 9;
+
+    struct ClientThread
+    {
+        std::thread thread;
+        std::shared_ptr<std::atomic<bool>> isFinished;
+    };
+
+    struct Connection
+    {
+        explicit Connection(std::unique_ptr<FrameChannel> frameChannel)
+            : channel(std::move(frameChannel))
+        {
+        }
+
+        std::unique_ptr<FrameChannel> channel;
+        std::mutex writeMutex;
+
+        std::mutex pendingMutex;
+        std::condition_variable hasPendingSlot;
+        size_t pendingCount = 0;
+        // Payload buffers of answered requests, they keep their capacity for the next ones.
+        std::vector<std::string> freeBuffers;
+    };
+
+    static void JoinFinishedClients(std::vector<ClientThread>& clients)
+    {
+        auto finished = std::partition(clients.begin(), clients.end(), [](const ClientThread& client) {
+            return !client.isFinished->load(std::memory_order_acquire);
+        });
+        for (auto it = finished; it != clients.end(); ++it)
+        {
+            it->thread.join();
+        }
+        clients.erase(finished, clients.end());
+    }
+
+    // A failing connection is dropped on its own, the server keeps serving the others.
+    void ServeConnection(const std::shared_ptr<Connection>& connection)
+    {
+        try
+        {
+            ReadRequests(connection);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+        catch (...)
+        {
+            std::cerr << "Error: unknown error on connection" << std::endl;
+        }
+    }
+
+    void ReadRequests(const std::shared_ptr<Connection>& connection)
+    {
+        char header[HEADER_SIZE];
+
+        while (connection->channel->Read(header, HEADER_SIZE))
+        {
+            uint32_t id = ReadUint32(header);
+            uint8_t type = static_cast<uint8_t>(header[4]);
+            uint32_t length = ReadUint32(header + 5);
+
+            if (length > MAX_PAYLOAD_SIZE)
+            {
+                // The stream cannot be resynchronized after an oversized frame.
+                WriteResponse(*connection, id, STATUS_ERROR, "Payload is too large");
+                return;
+            }
+
+            std::string payload;
+            {
+                std::unique_lock lock(connection->pendingMutex);
+                connection->hasPendingSlot.wait(lock, [&] { return connection->pendingCount < m_maxPendingRequests; });
+                ++connection->pendingCount;
+
+                if (!connection->freeBuffers.empty())
+                {
+                    payload = std::move(connection->freeBuffers.back());
+                    connection->freeBuffers.pop_back();
+                }
+            }
+
+            payload.resize(length);
+            if (!connection->channel->Read(payload.data(), length))
+            {
+                return;
+            }
+
+            m_workers.Submit([this, connection, id, type, payload = std::move(payload)]() mutable {
+                Process(*connection, id, type, payload);
+                {
+                    std::lock_guard lock(connection->pendingMutex);
+                    --connection->pendingCount;
+                    connection->freeBuffers.push_back(std::move(payload));
+                }
+                connection->hasPendingSlot.notify_one();
+            });
+        }
+    }
+
+    void Process(Connection& connection, uint32_t id, uint8_t type, const std::string& payload)
+    {
+        uint8_t status = STATUS_OK;
+        std::string result;
+
+        try
+        {
+            if (type > static_cast<uint8_t>(AutomataType::Moore))
+            {
+                throw std::invalid_argument("Invalid automaton type " + std::to_string(type));
+            }
+            result = MimCore::Minimize(static_cast<AutomataType>(type), payload, m_threadsPerRequest);
+        }
+        catch (const std::exception& e)
+        {
+            status = STATUS_ERROR;
+            result = e.what();
+        }
+
+        try
+        {
+            WriteResponse(connection, id, status, result);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+
+    void WriteResponse(Connection& connection, uint32_t id, uint8_t status, const std::string& payload)
+    {
+        char header[HEADER_SIZE];
+        WriteUint32(header, id);
+        header[4] = static_cast<char>(status);
+        WriteUint32(header + 5, static_cast<uint32_t>(payload.size()));
+
+        std::lock_guard lock(connection.writeMutex);
+        connection.channel->Write(header, HEADER_SIZE);
+        connection.channel->Write(payload.data(), payload.size());
+    }
+
+    static uint32_t ReadUint32(const char* data)
+    {
+        uint32_t value = 0;
+        for (int i = 3; i >= 0; --i)
+        {
+            value = value << 8 | static_cast<uint8_t>(data[i]);
+        }
+
+        return value;
+    }
+
+    static void WriteUint32(char* data, uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            data[i] = static_cast<char>(value >> (8 * i));
+        }
+    }
+
+    WorkerPool m_workers;
+    size_t m_maxPendingRequests;
+    size_t m_threadsPerRequest;
+};
@@ -1,47 +1,296 @@
+#include "Automata/BrzozowskiMinimizer.h"
 #include "Automata/MealyAutomata.h"
 #include "Automata/MooreAutomata.h"
+#include "Automata/ExternalMealyMinimizer.h"
+#include "Automata/IndexedAutomata.h"
+#include "Automata/LazyDfa.h"
+#include "Automata/ProductAutomata.h"
+#include "MimCore.h"
+#include "Server/MinimizeServer.h"
 #include <memory>
 #include <iostream>
+#include <map>
+#include <set>
 #include <string>
+#include <thread>
+#include <vector>
 
-void Minimize(std::unique_ptr<IAutomata> automat, const std::string& inputFile, const std::string& outputFile)
+void PrintStats(size_t statesCount, const IAutomata& automat)
+{
+    std::cout << "states: " << statesCount << " -> " << automat.GetStatesCount();
+    if (automat.IsAlreadyMinimal())
+    {
+        std::cout << ", already minimal";
+    }
+    std::cout << std::endl;
+}
+
+// Returns false when the table could not be read, minimized or written, the error is reported here.
+bool Minimize(std::unique_ptr<IAutomata> automat, const std::string& inputFile, const std::string& outputFile,
+              bool isPassthrough = false, bool isStatsEnabled = false)
 {
     try
     {
         automat->ReadFromFile(inputFile);
+        size_t statesCount = automat->GetStatesCount();
         automat->Minimize();
-        automat->PrintToFile(outputFile);
+
+        if (isPassthrough && automat->IsAlreadyMinimal())
+        {
+            std::filesystem::copy_file(inputFile, outputFile, std::filesystem::copy_options::overwrite_existing);
+        }
+        else
+        {
+            automat->PrintToFile(outputFile);
+        }
+
+        if (isStatsEnabled)
+        {
+            PrintStats(statesCount, *automat);
+        }
     }
     catch (const std::exception& e)
     {
         std::cerr << "Error during processing: " << e.what() << std::endl;
+        return false;
     }
+
+    return true;
+}
+
+void MinimizeWithReport(const std::string& inputFile, const std::string& outputFile, const std::string& reportFile)
+{
+    MealyAutomata automaton;
+    automaton.SetReportEnabled(true);
+    automaton.ReadFromFile(inputFile);
+    automaton.Minimize();
+    automaton.PrintToFile(outputFile);
+    automaton.GetReport().PrintToFile(reportFile);
+}
+
+void MinimizeExternal(const std::string& inputFile, const std::string& outputFile, size_t ramBudgetMb,
+                      const std::string& tempDirectory)
+{
+    ExternalMealyMinimizer minimizer(ramBudgetMb << 20, tempDirectory);
+    minimizer.Minimize(inputFile, outputFile);
+}
+
+void MinimizeBrzozowski(const std::string& inputFile, const std::string& outputFile)
+{
+    MooreAutomata automaton;
+    automaton.ReadFromFile(inputFile);
+
+    MooreAutomata minimized = BrzozowskiMinimizer::Minimize(automaton);
+    minimized.PrintToFile(outputFile);
 }
 
+void BuildProduct(ProductOperation operation, const std::string& leftFile, const std::string& rightFile,
+                  const std::string& outputFile, size_t threadsCount)
+{
+    MooreAutomata left;
+    left.ReadFromFile(leftFile);
+
+    MooreAutomata right;
+    right.ReadFromFile(rightFile);
+
+    MooreAutomata product = ProductAutomata::Build(left, right, operation);
+    product.SetParallelRefinement(threadsCount);
+    product.Minimize();
+    product.PrintToFile(outputFile);
+}
+
+void RunAutomaton(const std::string& automatonFile, const std::string& wordsFile, const std::string& outputFile,
+                  size_t cacheStates)
+{
+    MooreAutomata automaton;
+    automaton.ReadFromFile(automatonFile);
+
+    IndexedAutomata nfa(automaton);
+    LazyDfa dfa(nfa, cacheStates);
+
+    std::ifstream words(wordsFile);
+    if (!words.is_open())
+    {
+        throw std::invalid_argument("Could not open input file " + wordsFile);
+    }
+
+    std::ofstream output(outputFile);
+    if (!output.is_open())
+    {
+        throw std::runtime_error("Could not open output file " + outputFile);
+    }
+
+    std::string line;
+    while (std::getline(words, line))
+    {
+        std::stringstream ss(line);
+        std::vector<std::string> word;
+        std::string symbol;
+
+        while (ss >> symbol)
+        {
+            word.push_back(symbol);
+        }
+
+        output << (dfa.Accepts(word) ? "accept" : "reject") << "\n";
+    }
+}
+
+void PrintUsage(const std::string& program)
+{
+    std::cerr << "Usage: " << program << " mealy|moore [--passthrough] [--stats] input.csv output.csv" << std::endl;
+    std::cerr << "   or: " << program << " moore [--threads=N] moore.csv moore_min.csv" << std::endl;
+    std::cerr << "   or: " << program << " mealy [--report=report.csv] mealy.csv mealy_min.csv" << std::endl;
+    std::cerr << "   or: " << program << " mealy --external [--ram-budget=MB] [--temp-dir=DIR] mealy.csv mealy_min.csv"
+              << std::endl;
+    std::cerr << "   or: " << program << " moore [--algo=refinement|brzozowski] moore.csv moore_min.csv" << std::endl;
+    std::cerr << "   or: " << program << " intersect|union|diff [--threads=N] first.csv second.csv result.csv" << std::endl;
+    std::cerr << "   or: " << program << " run [--cache-states=N] nfa.csv words.txt result.txt" << std::endl;
+    std::cerr << "   or: " << program << " serve [--socket=PATH] [--workers=N] [--threads=N]" << std::endl;
+}
 
 int main(int argc, char* argv[])
 {
-    if (argc != 4)
+    const std::map<std::string, ProductOperation> productCommands = {
+        {"intersect", ProductOperation::Intersection},
+        {"union", ProductOperation::Union},
+        {"diff", ProductOperation::Difference},
+    };
+    const std::map<std::string, std::set<std::string>> commandOptions = {
+        {"mealy", {"passthrough", "stats", "report", "external", "ram-budget", "temp-dir", "algo"}},
+        {"moore", {"passthrough", "stats", "algo", "threads"}},
+        {"intersect", {"threads"}},
+        {"union", {"threads"}},
+        {"diff", {"threads"}},
+        {"run", {"cache-states"}},
+        {"serve", {"socket", "workers", "threads"}},
+    };
+
+    std::vector<std::string> arguments;
+    std::map<std::string, std::string> options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument.starts_with("--"))
+        {
+            auto pos = argument.find('=');
+            options[argument.substr(2, pos - 2)] = pos == std::string::npos ? "" : argument.substr(pos + 1);
+        }
+        else
+        {
+            arguments.push_back(argument);
+        }
+    }
+
+    std::string command = arguments.empty() ? "" : arguments[0];
+    bool isProductCommand = productCommands.contains(command);
+    size_t expectedArguments = isProductCommand || command == "run" ? 4 : command == "serve" ? 1 : 3;
+
+    if (arguments.size() != expectedArguments)
     {
         std::cerr << "Wrong input data" << std::endl;
-        std::cerr << "Usage: " << argv[0] << " mealy mealy.csv mealy_min.csv" << std::endl;
-        std::cerr << "   or: " << argv[0] << " moore mealy.csv mealy_min.csv" << std::endl;
+        PrintUsage(argv[0]);
         return 1;
     }
 
-    std::string command = argv[1];
-    std::string inputFile = argv[2];
-    std::string outputFile = argv[3];
+    if (commandOptions.contains(command))
+    {
+        for (auto& [option, value]: options)
+        {
+            if (!commandOptions.at(command).contains(option))
+            {
+                std::cerr << "Unknown option for " << command << ": --" << option << std::endl;
+                PrintUsage(argv[0]);
+                return 1;
+            }
+        }
+    }
+
+    std::string algorithm = options.contains("algo") ? options.at("algo") : "refinement";
+    // A served request gets one thread, the workers run many requests at once.
+    size_t threadsCount = options.contains("threads")
+                          ? std::stoul(options.at("threads"))
+                          : command == "serve" ? 1 : std::max(std::thread::hardware_concurrency(), 1u);
 
     try {
-        if (command == "mealy")
+        if (algorithm != "refinement" && (algorithm != "brzozowski" || command != "moore"))
+        {
+            throw std::invalid_argument("Invalid algorithm for " + command + ": " + algorithm);
+        }
+
+        if (options.contains("report") && (command != "mealy" || options.contains("external")))
+        {
+            throw std::invalid_argument("The report is only available for in-memory mealy minimization");
+        }
+
+        if ((options.contains("ram-budget") || options.contains("temp-dir")) && !options.contains("external"))
+        {
+            throw std::invalid_argument("--ram-budget and --temp-dir are only available with --external");
+        }
+
+        if ((options.contains("passthrough") || options.contains("stats"))
+            && (options.contains("external") || options.contains("report") || algorithm == "brzozowski"))
+        {
+            throw std::invalid_argument("--passthrough and --stats are only available for in-memory refinement");
+        }
+
+        if (options.contains("threads") && algorithm == "brzozowski")
+        {
+            throw std::invalid_argument("--threads is only available for refinement");
+        }
+
+        if (command == "mealy" && options.contains("external"))
+        {
+            size_t ramBudgetMb = options.contains("ram-budget")
+                                 ? std::stoul(options.at("ram-budget"))
+                                 : ExternalMealyMinimizer::DEFAULT_RAM_BUDGET_MB;
+            if (ramBudgetMb < ExternalMealyMinimizer::MIN_RAM_BUDGET_MB)
+            {
+                throw std::invalid_argument("RAM budget must be at least "
+                                            + std::to_string(ExternalMealyMinimizer::MIN_RAM_BUDGET_MB) + " MB");
+            }
+            std::string tempDirectory = options.contains("temp-dir")
+                                        ? options.at("temp-dir")
+                                        : std::filesystem::temp_directory_path().string();
+            MinimizeExternal(arguments[1], arguments[2], ramBudgetMb, tempDirectory);
+        } else if (command == "mealy" && options.contains("report"))
+        {
+            MinimizeWithReport(arguments[1], arguments[2], options.at("report"));
+        } else if (command == "moore" && algorithm == "brzozowski")
+        {
+            MinimizeBrzozowski(arguments[1], arguments[2]);
+        } else if (command == "mealy" || command == "moore")
+        {
+            auto automaton = MimCore::CreateAutomata(MimCore::ParseAutomataType(command), threadsCount);
+            if (!Minimize(std::move(automaton), arguments[1], arguments[2], options.contains("passthrough"),
+                          options.contains("stats")))
+            {
+                return 1;
+            }
+        } else if (isProductCommand)
+        {
+            BuildProduct(productCommands.at(command), arguments[1], arguments[2], arguments[3], threadsCount);
+        } else if (command == "run")
         {
-            auto automaton = std::make_unique<MealyAutomata>();
-            Minimize(std::move(automaton), inputFile, outputFile);
-        } else if (command == "moore")
+            size_t cacheStates = options.contains("cache-states")
+                                 ? std::stoul(options.at("cache-states"))
+                                 : LazyDfa::DEFAULT_CACHE_STATES;
+            RunAutomaton(arguments[1], arguments[2], arguments[3], cacheStates);
+        } else if (command == "serve")
         {
-            auto automaton = std::make_unique<MooreAutomata>();
-            Minimize(std::move(automaton), inputFile, outputFile);
+            size_t workersCount = options.contains("workers")
+                                  ? std::stoul(options.at("workers"))
+                                  : std::max(std::thread::hardware_concurrency(), 1u);
+            MinimizeServer server(workersCount, threadsCount);
+            if (options.contains("socket"))
+            {
+                server.ServeSocket(options.at("socket"));
+            }
+            else
+            {
+                server.ServeStream(stdin, stdout);
+            }
         } else
         {
             throw std::invalid_argument("Invalid automaton command: " + command);
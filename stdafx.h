@@ -12,6 +12,7 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <algorithm>
+#include <bit>
 #include <fstream>
 #include <stdexcept>
 
@@ -0,0 +1,949 @@
+// Differential harness for the minimizers.
+//
+// Generates random Mealy tables and Moore acceptors, minimizes them with every
+// registered engine and checks that each result is equivalent to the input and has
+// the same number of states as the reference refinement. Products of two acceptors
+// are checked against the pairwise run of their operands, the lazy DFA runtime against
+// the eager subset construction on random words. Built either as a
+// standalone driver (random tables from a seed) or, with MIM_LIBFUZZER, as a
+// libFuzzer target that derives the table from the fuzzer input.
+
+#include "../Automata/BrzozowskiMinimizer.h"
+#include "../Automata/ExternalMealyMinimizer.h"
+#include "../Automata/MealyAutomata.h"
+#include "../Automata/MooreAutomata.h"
+#include "../Automata/IndexedAutomata.h"
+#include "../Automata/LazyDfa.h"
+#include "../Automata/ProductAutomata.h"
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+class RandomSource
+{
+public:
+    virtual uint32_t Next(uint32_t bound) = 0;
+    virtual ~RandomSource() = default;
+};
+
+class SeededSource final : public RandomSource
+{
+public:
+    explicit SeededSource(uint64_t seed)
+        : m_engine(seed)
+    {
+    }
+
+    uint32_t Next(uint32_t bound) override
+    {
+        return std::uniform_int_distribution<uint32_t>(0, bound - 1)(m_engine);
+    }
+
+private:
+    std::mt19937_64 m_engine;
+};
+
+class BytesSource final : public RandomSource
+{
+public:
+    BytesSource(const uint8_t* data, size_t size)
+        : m_data(data)
+        , m_size(size)
+    {
+    }
+
+    uint32_t Next(uint32_t bound) override
+    {
+        uint32_t value = 0;
+        for (int i = 0; i < 2; ++i)
+        {
+            value = value << 8 | (m_position < m_size ? m_data[m_position++] : 0);
+        }
+
+        return value % bound;
+    }
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_position = 0;
+};
+
+// Dense form of a Mealy table as printed by MealyAutomata, the first column is the start state.
+struct MealyTable
+{
+    std::vector<std::string> states;
+    std::vector<std::string> inputs;
+    std::vector<std::vector<uint32_t>> next;
+    std::vector<std::vector<std::string>> outputs;
+
+    static MealyTable Parse(const std::string& text)
+    {
+        MealyTable table;
+        std::stringstream lines(text);
+        std::string line;
+        std::string cell;
+
+        std::getline(lines, line);
+        std::stringstream header(line);
+        std::getline(header, cell, ';');
+        std::map<std::string, uint32_t> stateIndexes;
+        while (std::getline(header, cell, ';'))
+        {
+            stateIndexes.emplace(cell, static_cast<uint32_t>(table.states.size()));
+            table.states.push_back(cell);
+        }
+
+        while (std::getline(lines, line))
+        {
+            std::stringstream row(line);
+            std::getline(row, cell, ';');
+            table.inputs.push_back(cell);
+            table.next.emplace_back();
+            table.outputs.emplace_back();
+
+            while (std::getline(row, cell, ';'))
+            {
+                auto pos = cell.find('/');
+                table.next.back().push_back(stateIndexes.at(cell.substr(0, pos)));
+                table.outputs.back().push_back(cell.substr(pos + 1));
+            }
+        }
+
+        return table;
+    }
+
+    [[nodiscard]] std::string Print() const
+    {
+        std::string text;
+        for (auto& state: states)
+        {
+            text += ";" + state;
+        }
+        text += "\n";
+
+        for (size_t input = 0; input < inputs.size(); ++input)
+        {
+            text += inputs[input];
+            for (size_t state = 0; state < states.size(); ++state)
+            {
+                text += ";" + states[next[input][state]] + "/" + outputs[input][state];
+            }
+            text += "\n";
+        }
+
+        return text;
+    }
+};
+
+// Independent Moore-style refinement over integers, used as the expected state count.
+class ReferenceMinimizer
+{
+public:
+    static size_t CountMealyStates(const MealyTable& table)
+    {
+        std::vector<uint32_t> initial(table.states.size());
+        std::map<std::vector<std::string>, uint32_t> outputClasses;
+        for (size_t state = 0; state < table.states.size(); ++state)
+        {
+            std::vector<std::string> key;
+            for (auto& row: table.outputs)
+            {
+                key.push_back(row[state]);
+            }
+            initial[state] = outputClasses.emplace(key, outputClasses.size()).first->second;
+        }
+
+        return CountClasses(table.next, initial, 0);
+    }
+
+    static size_t CountMooreStates(const IndexedAutomata& automata)
+    {
+        size_t statesCount = automata.GetStatesCount();
+        size_t inputsCount = automata.GetInputsCount();
+        auto dead = static_cast<uint32_t>(statesCount);
+
+        std::vector<std::vector<uint32_t>> next(inputsCount, std::vector<uint32_t>(statesCount + 1, dead));
+        std::vector<uint32_t> initial(statesCount + 1, 0);
+        for (uint32_t state = 0; state < statesCount; ++state)
+        {
+            initial[state] = automata.IsFinalState(state) ? 1 : 0;
+            for (uint32_t input = 0; input < inputsCount; ++input)
+            {
+                uint32_t nextState = automata.GetNextState(state, input);
+                next[input][state] = nextState == IndexedAutomata::NO_STATE ? dead : nextState;
+            }
+        }
+
+        return CountClasses(next, initial, automata.GetStartState(), true);
+    }
+
+    // Same count when states that cannot reach a final state are folded into the dead state.
+    static size_t CountTrimMooreStates(const IndexedAutomata& automata)
+    {
+        size_t statesCount = automata.GetStatesCount();
+        size_t inputsCount = automata.GetInputsCount();
+        auto dead = static_cast<uint32_t>(statesCount);
+
+        std::vector<bool> isCoreachable(statesCount, false);
+        for (bool isChanged = true; isChanged;)
+        {
+            isChanged = false;
+            for (uint32_t state = 0; state < statesCount; ++state)
+            {
+                bool isStateCoreachable = automata.IsFinalState(state);
+                for (uint32_t input = 0; input < inputsCount && !isStateCoreachable; ++input)
+                {
+                    uint32_t nextState = automata.GetNextState(state, input);
+                    isStateCoreachable = nextState != IndexedAutomata::NO_STATE && isCoreachable[nextState];
+                }
+
+                if (isStateCoreachable && !isCoreachable[state])
+                {
+                    isCoreachable[state] = true;
+                    isChanged = true;
+                }
+            }
+        }
+
+        std::vector<std::vector<uint32_t>> next(inputsCount, std::vector<uint32_t>(statesCount + 1, dead));
+        std::vector<uint32_t> initial(statesCount + 1, 0);
+        for (uint32_t state = 0; state < statesCount; ++state)
+        {
+            initial[state] = automata.IsFinalState(state) ? 1 : 0;
+            for (uint32_t input = 0; input < inputsCount; ++input)
+            {
+                uint32_t nextState = automata.GetNextState(state, input);
+                next[input][state] = nextState == IndexedAutomata::NO_STATE || !isCoreachable[nextState]
+                                     ? dead
+                                     : nextState;
+            }
+        }
+
+        return CountClasses(next, initial, automata.GetStartState(), true);
+    }
+
+private:
+    static size_t CountClasses(const std::vector<std::vector<uint32_t>>& next, std::vector<uint32_t> classes,
+                               uint32_t start, bool hasDeadState = false)
+    {
+        std::vector<bool> isReachable(classes.size(), false);
+        std::vector<uint32_t> queue = {start};
+        isReachable[start] = true;
+        for (size_t index = 0; index < queue.size(); ++index)
+        {
+            for (auto& row: next)
+            {
+                if (!isReachable[row[queue[index]]])
+                {
+                    isReachable[row[queue[index]]] = true;
+                    queue.push_back(row[queue[index]]);
+                }
+            }
+        }
+
+        size_t classesCount = 0;
+        while (true)
+        {
+            std::map<std::vector<uint32_t>, uint32_t> signatures;
+            std::vector<uint32_t> newClasses(classes.size());
+            for (uint32_t state: queue)
+            {
+                std::vector<uint32_t> key = {classes[state]};
+                for (auto& row: next)
+                {
+                    key.push_back(classes[row[state]]);
+                }
+                newClasses[state] = signatures.emplace(key, signatures.size()).first->second;
+            }
+
+            classes = newClasses;
+            if (signatures.size() == classesCount)
+            {
+                break;
+            }
+            classesCount = signatures.size();
+        }
+
+        if (hasDeadState && isReachable.back())
+        {
+            // The implicit dead state is not materialized when its class holds nothing else.
+            uint32_t deadClass = classes.back();
+            bool isShared = false;
+            for (size_t state = 0; state + 1 < classes.size(); ++state)
+            {
+                isShared = isShared || (isReachable[state] && classes[state] == deadClass);
+            }
+
+            if (!isShared)
+            {
+                --classesCount;
+            }
+        }
+
+        return classesCount;
+    }
+};
+
+class EquivalenceChecker
+{
+public:
+    static bool AreMealyEquivalent(const MealyTable& left, const MealyTable& right)
+    {
+        if (left.inputs != right.inputs)
+        {
+            return false;
+        }
+
+        std::map<std::pair<uint32_t, uint32_t>, bool> visited;
+        std::vector<std::pair<uint32_t, uint32_t>> queue = {{0, 0}};
+        visited[queue.front()] = true;
+
+        for (size_t index = 0; index < queue.size(); ++index)
+        {
+            auto [leftState, rightState] = queue[index];
+            for (size_t input = 0; input < left.inputs.size(); ++input)
+            {
+                if (left.outputs[input][leftState] != right.outputs[input][rightState])
+                {
+                    return false;
+                }
+
+                std::pair<uint32_t, uint32_t> nextPair = {left.next[input][leftState], right.next[input][rightState]};
+                if (!visited[nextPair])
+                {
+                    visited[nextPair] = true;
+                    queue.push_back(nextPair);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    static bool AreMooreEquivalent(const IndexedAutomata& left, const IndexedAutomata& right)
+    {
+        auto leftDead = static_cast<uint32_t>(left.GetStatesCount());
+        auto rightDead = static_cast<uint32_t>(right.GetStatesCount());
+
+        std::map<std::pair<uint32_t, uint32_t>, bool> visited;
+        std::vector<std::pair<uint32_t, uint32_t>> queue = {{left.GetStartState(), right.GetStartState()}};
+        visited[queue.front()] = true;
+
+        for (size_t index = 0; index < queue.size(); ++index)
+        {
+            auto [leftState, rightState] = queue[index];
+            bool isLeftFinal = leftState != leftDead && left.IsFinalState(leftState);
+            bool isRightFinal = rightState != rightDead && right.IsFinalState(rightState);
+            if (isLeftFinal != isRightFinal)
+            {
+                return false;
+            }
+
+            for (auto& input: left.GetInputs())
+            {
+                std::pair<uint32_t, uint32_t> nextPair = {GetNextState(left, leftState, input, leftDead),
+                                                          GetNextState(right, rightState, input, rightDead)};
+                if (!visited[nextPair])
+                {
+                    visited[nextPair] = true;
+                    queue.push_back(nextPair);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // Runs the operands and the product side by side over every input of the operands.
+    static bool IsProductOf(const IndexedAutomata& left, const IndexedAutomata& right, const IndexedAutomata& product,
+                            ProductOperation operation)
+    {
+        auto leftDead = static_cast<uint32_t>(left.GetStatesCount());
+        auto rightDead = static_cast<uint32_t>(right.GetStatesCount());
+        auto productDead = static_cast<uint32_t>(product.GetStatesCount());
+
+        std::vector<std::string> inputs = left.GetInputs();
+        inputs.insert(inputs.end(), right.GetInputs().begin(), right.GetInputs().end());
+
+        using Triple = std::tuple<uint32_t, uint32_t, uint32_t>;
+        std::map<Triple, bool> visited;
+        std::vector<Triple> queue = {{left.GetStartState(), right.GetStartState(), product.GetStartState()}};
+        visited[queue.front()] = true;
+
+        for (size_t index = 0; index < queue.size(); ++index)
+        {
+            auto [leftState, rightState, productState] = queue[index];
+            bool isLeftFinal = leftState != leftDead && left.IsFinalState(leftState);
+            bool isRightFinal = rightState != rightDead && right.IsFinalState(rightState);
+            bool isProductFinal = productState != productDead && product.IsFinalState(productState);
+
+            bool isExpectedFinal = operation == ProductOperation::Intersection ? isLeftFinal && isRightFinal
+                                   : operation == ProductOperation::Union      ? isLeftFinal || isRightFinal
+                                                                               : isLeftFinal && !isRightFinal;
+            if (isProductFinal != isExpectedFinal)
+            {
+                return false;
+            }
+
+            for (auto& input: inputs)
+            {
+                Triple nextTriple = {GetNextState(left, leftState, input, leftDead),
+                                     GetNextState(right, rightState, input, rightDead),
+                                     GetNextState(product, productState, input, productDead)};
+                if (!visited[nextTriple])
+                {
+                    visited[nextTriple] = true;
+                    queue.push_back(nextTriple);
+                }
+            }
+        }
+
+        return true;
+    }
+
+private:
+    static uint32_t GetNextState(const IndexedAutomata& automata, uint32_t state, const std::string& input,
+                                 uint32_t dead)
+    {
+        uint32_t inputIndex = automata.GetInputIndex(input);
+        if (state == dead || inputIndex == IndexedAutomata::NO_INPUT)
+        {
+            return dead;
+        }
+
+        uint32_t nextState = automata.GetNextState(state, inputIndex);
+        return nextState == IndexedAutomata::NO_STATE ? dead : nextState;
+    }
+};
+
+class TableGenerator
+{
+public:
+    TableGenerator(RandomSource& random, uint32_t maxStates)
+        : m_random(random)
+        , m_maxStates(maxStates)
+    {
+    }
+
+    MealyTable GenerateMealy()
+    {
+        uint32_t statesCount = 1 + m_random.Next(m_maxStates);
+        uint32_t inputsCount = 1 + m_random.Next(MAX_INPUTS);
+        uint32_t outputsCount = 1 + m_random.Next(MAX_OUTPUTS);
+        // Few distinct transition targets make equivalent states, and so merges, likely.
+        uint32_t targetsCount = 1 + m_random.Next(statesCount);
+
+        MealyTable table;
+        for (uint32_t state = 0; state < statesCount; ++state)
+        {
+            table.states.push_back("q" + std::to_string(state));
+        }
+
+        for (uint32_t input = 0; input < inputsCount; ++input)
+        {
+            table.inputs.push_back("z" + std::to_string(input + 1));
+            table.next.emplace_back();
+            table.outputs.emplace_back();
+            for (uint32_t state = 0; state < statesCount; ++state)
+            {
+                table.next.back().push_back(m_random.Next(targetsCount));
+                table.outputs.back().push_back("w" + std::to_string(m_random.Next(outputsCount) + 1));
+            }
+        }
+
+        return table;
+    }
+
+    std::string GenerateMoore()
+    {
+        uint32_t statesCount = 1 + m_random.Next(m_maxStates);
+        uint32_t inputsCount = 1 + m_random.Next(MAX_INPUTS);
+        uint32_t targetsCount = 1 + m_random.Next(statesCount);
+
+        std::string outputs;
+        std::string states;
+        for (uint32_t state = 0; state < statesCount; ++state)
+        {
+            // The reader requires at least one final state.
+            bool isFinal = state == statesCount - 1 || m_random.Next(2) == 0;
+            outputs += isFinal ? ";F" : ";";
+            states += ";s" + std::to_string(state);
+        }
+
+        std::string text = outputs + "\n" + states + "\n";
+        for (uint32_t input = 0; input < inputsCount; ++input)
+        {
+            text += "x" + std::to_string(input + 1);
+            for (uint32_t state = 0; state < statesCount; ++state)
+            {
+                // The first transition of the start state keeps the last (final) state reachable,
+                // otherwise the minimized machine has no final state and cannot be read back.
+                uint32_t nextState = input == 0 && state == 0 ? statesCount - 1 : m_random.Next(targetsCount);
+                text += ";s" + std::to_string(nextState);
+            }
+            text += "\n";
+        }
+
+        return text;
+    }
+
+    // An acceptor with up to two targets per cell and sometimes ε-moves, plus words over its inputs.
+    // Words may hold an unknown symbol, both runtimes must reject them.
+    std::string GenerateNfa(std::vector<std::vector<std::string>>& words)
+    {
+        uint32_t statesCount = 1 + m_random.Next(std::min(m_maxStates, MAX_NFA_STATES));
+        uint32_t inputsCount = 1 + m_random.Next(MAX_INPUTS);
+        bool hasEpsilon = m_random.Next(2) == 0;
+
+        std::string outputs;
+        std::string states;
+        for (uint32_t state = 0; state < statesCount; ++state)
+        {
+            outputs += m_random.Next(3) == 0 ? ";F" : ";";
+            states += ";s" + std::to_string(state);
+        }
+
+        std::string text = outputs + "\n" + states + "\n";
+        for (uint32_t input = 0; input < inputsCount + (hasEpsilon ? 1 : 0); ++input)
+        {
+            bool isEpsilon = input == inputsCount;
+            text += isEpsilon ? E_CLOSE : "x" + std::to_string(input + 1);
+            for (uint32_t state = 0; state < statesCount; ++state)
+            {
+                std::string cell;
+                for (uint32_t target = m_random.Next(isEpsilon ? 2 : 3); target > 0; --target)
+                {
+                    cell += (cell.empty() ? "s" : ",s") + std::to_string(m_random.Next(statesCount));
+                }
+                text += ";" + cell;
+            }
+            text += "\n";
+        }
+
+        words.clear();
+        for (uint32_t word = 0; word < WORDS_COUNT; ++word)
+        {
+            words.emplace_back();
+            for (uint32_t length = m_random.Next(MAX_WORD_LENGTH + 1); length > 0; --length)
+            {
+                uint32_t input = m_random.Next(inputsCount * 16 + 1);
+                words.back().push_back(input == inputsCount * 16 ? "x0" : "x" + std::to_string(input % inputsCount + 1));
+            }
+        }
+
+        return text;
+    }
+
+private:
+    static constexpr uint32_t MAX_INPUTS = 8;
+    static constexpr uint32_t MAX_OUTPUTS = 4;
+    // Keeps the eager subset construction of the reference small.
+    static constexpr uint32_t MAX_NFA_STATES = 12;
+    static constexpr uint32_t WORDS_COUNT = 16;
+    static constexpr uint32_t MAX_WORD_LENGTH = 12;
+
+    RandomSource& m_random;
+    uint32_t m_maxStates;
+};
+
+// Engines read a table from a file, minimize it and leave the result in a file.
+struct Engine
+{
+    std::string name;
+    std::function<void(const std::string& inputFile, const std::string& outputFile)> minimize;
+    double seconds = 0;
+    size_t states = 0;
+    // The result drops states that cannot reach a final state.
+    bool isTrimming = false;
+    // Engines with an exponential worst case only get tables up to this size.
+    size_t maxStates = std::numeric_limits<size_t>::max();
+    // Fast paths picked automatically must print exactly what the first engine of their kind prints.
+    bool isByteIdentical = false;
+};
+
+class DifferentialHarness
+{
+public:
+    DifferentialHarness()
+        : m_inputFile(std::filesystem::temp_directory_path() / "mim_fuzz_input.csv")
+        , m_outputFile(std::filesystem::temp_directory_path() / "mim_fuzz_output.csv")
+    {
+        AddMealyEngine("scalar", false, SignatureKernel::Scalar);
+        // Every vector kernel the CPU has, not only the one picked by default.
+        for (auto [name, kernel]: {std::pair("avx2", SignatureKernel::Avx2), std::pair("avx512", SignatureKernel::Avx512)})
+        {
+            if (SignatureHasher::IsKernelSupported(kernel))
+            {
+                AddMealyEngine(name, false, kernel, true);
+            }
+        }
+        AddMealyEngine("small", true, SignatureHasher::GetBestKernel(), true);
+        // A tiny budget forces multi-run external sorts even on small tables.
+        m_mealyEngines.push_back({"external", [](const std::string& inputFile, const std::string& outputFile) {
+            ExternalMealyMinimizer minimizer(4096, std::filesystem::temp_directory_path());
+            minimizer.Minimize(inputFile, outputFile);
+        }});
+
+        AddMooreEngine("legacy", false);
+        AddMooreEngine("small", true, true);
+        // Chunks of a few states make every block go through the merge of chunk splits.
+        Engine parallel = {"parallel", [](const std::string& inputFile, const std::string& outputFile) {
+            MooreAutomata automata;
+            automata.SetSmallPathEnabled(false);
+            automata.SetParallelRefinement(4, 0, 3);
+            automata.ReadFromFile(inputFile);
+            automata.Minimize();
+            automata.PrintToFile(outputFile);
+        }};
+        parallel.isByteIdentical = true;
+        m_mooreEngines.push_back(std::move(parallel));
+        Engine brzozowski = {"brzozowski", [](const std::string& inputFile, const std::string& outputFile) {
+            MooreAutomata automata;
+            automata.ReadFromFile(inputFile);
+            BrzozowskiMinimizer::Minimize(automata).PrintToFile(outputFile);
+        }};
+        brzozowski.isTrimming = true;
+        brzozowski.maxStates = 16;
+        m_mooreEngines.push_back(std::move(brzozowski));
+    }
+
+    bool CheckMealy(const MealyTable& table)
+    {
+        std::string text = table.Print();
+        WriteFile(m_inputFile, text);
+        size_t expectedStates = ReferenceMinimizer::CountMealyStates(table);
+
+        std::string firstOutput;
+        for (auto& engine: m_mealyEngines)
+        {
+            RunEngine(engine, table.states.size());
+            std::string output = ReadFile(m_outputFile);
+            MealyTable result = MealyTable::Parse(output);
+
+            if (result.states.size() != expectedStates || !EquivalenceChecker::AreMealyEquivalent(table, result))
+            {
+                return Report("mealy", engine, text, expectedStates, result.states.size());
+            }
+
+            if (!IsSameOutput(engine, firstOutput, output))
+            {
+                return ReportOutput("mealy", engine, text, firstOutput, output);
+            }
+        }
+
+        return true;
+    }
+
+    bool CheckMoore(const std::string& text)
+    {
+        WriteFile(m_inputFile, text);
+        MooreAutomata source;
+        source.ReadFromFile(m_inputFile);
+        IndexedAutomata sourceIndexed(source);
+        size_t expectedStates = ReferenceMinimizer::CountMooreStates(sourceIndexed);
+        size_t expectedTrimStates = ReferenceMinimizer::CountTrimMooreStates(sourceIndexed);
+        std::string firstOutput;
+
+        for (auto& engine: m_mooreEngines)
+        {
+            if (sourceIndexed.GetStatesCount() > engine.maxStates)
+            {
+                continue;
+            }
+
+            size_t engineExpectedStates = engine.isTrimming ? expectedTrimStates : expectedStates;
+            RunEngine(engine, sourceIndexed.GetStatesCount());
+            MooreAutomata result;
+            result.ReadFromFile(m_outputFile);
+            IndexedAutomata resultIndexed(result);
+
+            if (resultIndexed.GetStatesCount() != engineExpectedStates ||
+                !EquivalenceChecker::AreMooreEquivalent(sourceIndexed, resultIndexed))
+            {
+                return Report("moore", engine, text, engineExpectedStates, resultIndexed.GetStatesCount());
+            }
+
+            std::string output = ReadFile(m_outputFile);
+            if (!IsSameOutput(engine, firstOutput, output))
+            {
+                return ReportOutput("moore", engine, text, firstOutput, output);
+            }
+        }
+
+        return true;
+    }
+
+    // The result goes through the file format, so a product without final states must read back.
+    bool CheckProducts(const std::string& leftText, const std::string& rightText)
+    {
+        auto left = ReadMoore(leftText);
+        auto right = ReadMoore(rightText);
+        IndexedAutomata leftIndexed(left);
+        IndexedAutomata rightIndexed(right);
+
+        const std::vector<std::pair<std::string, ProductOperation>> operations = {
+            {"intersect", ProductOperation::Intersection},
+            {"union", ProductOperation::Union},
+            {"diff", ProductOperation::Difference},
+        };
+
+        // A machine minus itself has an empty language.
+        for (auto& [leftOperand, rightOperand]: {std::pair(&left, &right), std::pair(&left, &left)})
+        {
+            for (auto& [name, operation]: operations)
+            {
+                MooreAutomata product = ProductAutomata::Build(*leftOperand, *rightOperand, operation);
+                product.Minimize();
+                product.PrintToFile(m_outputFile.string());
+
+                MooreAutomata result;
+                result.ReadFromFile(m_outputFile.string());
+                IndexedAutomata resultIndexed(result);
+
+                auto& rightIndexedOperand = rightOperand == &left ? leftIndexed : rightIndexed;
+                if (!EquivalenceChecker::IsProductOf(leftIndexed, rightIndexedOperand, resultIndexed, operation))
+                {
+                    std::cerr << "product/" << name << " mismatch for" << std::endl
+                              << leftText << "and" << std::endl << (rightOperand == &left ? leftText : rightText);
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // A cache of two states flushes on almost every new subset.
+    bool CheckLazyDfa(const std::string& text, const std::vector<std::vector<std::string>>& words)
+    {
+        auto nfa = ReadMoore(text);
+        IndexedAutomata nfaIndexed(nfa);
+        LazyDfa lazyDfa(nfaIndexed, LAZY_CACHE_STATES);
+        IndexedAutomata dfa(BrzozowskiMinimizer::Determinize(nfa));
+
+        for (auto& word: words)
+        {
+            ++m_lazyWordsCount;
+            if (lazyDfa.Accepts(word) != IsAcceptedByDfa(dfa, word))
+            {
+                std::cerr << "lazy mismatch on \"";
+                for (auto& symbol: word)
+                {
+                    std::cerr << symbol << " ";
+                }
+                std::cerr << "\" for" << std::endl << text;
+                return false;
+            }
+        }
+        m_lazyFlushesCount += lazyDfa.GetCacheFlushesCount();
+
+        return true;
+    }
+
+    void PrintThroughput() const
+    {
+        for (auto* engines: {&m_mealyEngines, &m_mooreEngines})
+        {
+            std::string kind = engines == &m_mealyEngines ? "mealy" : "moore";
+            for (auto& engine: *engines)
+            {
+                std::cout << kind << "/" << engine.name << ": " << engine.states << " states in "
+                          << engine.seconds << " s, " << static_cast<size_t>(engine.states / engine.seconds)
+                          << " states/s" << std::endl;
+            }
+        }
+
+        std::cout << "lazy: " << m_lazyWordsCount << " words, " << m_lazyFlushesCount << " cache flushes"
+                  << std::endl;
+    }
+
+private:
+    void AddMealyEngine(const std::string& name, bool isSmallPathEnabled, SignatureKernel kernel,
+                        bool isByteIdentical = false)
+    {
+        Engine engine = {name, [=](const std::string& inputFile, const std::string& outputFile) {
+            MealyAutomata automata;
+            automata.SetSmallPathEnabled(isSmallPathEnabled);
+            automata.SetSignatureKernel(kernel);
+            automata.ReadFromFile(inputFile);
+            automata.Minimize();
+            automata.PrintToFile(outputFile);
+        }};
+        engine.isByteIdentical = isByteIdentical;
+        m_mealyEngines.push_back(std::move(engine));
+    }
+
+    void AddMooreEngine(const std::string& name, bool isSmallPathEnabled, bool isByteIdentical = false)
+    {
+        Engine engine = {name, [=](const std::string& inputFile, const std::string& outputFile) {
+            MooreAutomata automata;
+            automata.SetSmallPathEnabled(isSmallPathEnabled);
+            automata.ReadFromFile(inputFile);
+            automata.Minimize();
+            automata.PrintToFile(outputFile);
+        }};
+        engine.isByteIdentical = isByteIdentical;
+        m_mooreEngines.push_back(std::move(engine));
+    }
+
+    // The first engine of a kind sets the expected output.
+    static bool IsSameOutput(const Engine& engine, std::string& firstOutput, const std::string& output)
+    {
+        if (firstOutput.empty())
+        {
+            firstOutput = output;
+            return true;
+        }
+
+        return !engine.isByteIdentical || output == firstOutput;
+    }
+
+    void RunEngine(Engine& engine, size_t statesCount) const
+    {
+        auto start = std::chrono::steady_clock::now();
+        engine.minimize(m_inputFile.string(), m_outputFile.string());
+        engine.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        engine.states += statesCount;
+    }
+
+    static bool Report(const std::string& kind, const Engine& engine, const std::string& text,
+                       size_t expectedStates, size_t actualStates)
+    {
+        std::cerr << kind << "/" << engine.name << " mismatch: expected " << expectedStates
+                  << " states, got " << actualStates << " (or a non-equivalent machine) for" << std::endl
+                  << text;
+
+        return false;
+    }
+
+    static constexpr size_t LAZY_CACHE_STATES = 2;
+
+    static bool IsAcceptedByDfa(const IndexedAutomata& dfa, const std::vector<std::string>& word)
+    {
+        uint32_t state = dfa.GetStartState();
+        for (auto& symbol: word)
+        {
+            uint32_t input = dfa.GetInputIndex(symbol);
+            state = input == IndexedAutomata::NO_INPUT ? IndexedAutomata::NO_STATE : dfa.GetNextState(state, input);
+            if (state == IndexedAutomata::NO_STATE)
+            {
+                return false;
+            }
+        }
+
+        return dfa.IsFinalState(state);
+    }
+
+    MooreAutomata ReadMoore(const std::string& text) const
+    {
+        WriteFile(m_inputFile, text);
+        MooreAutomata automata;
+        automata.ReadFromFile(m_inputFile.string());
+
+        return automata;
+    }
+
+    static bool ReportOutput(const std::string& kind, const Engine& engine, const std::string& text,
+                             const std::string& expectedOutput, const std::string& output)
+    {
+        std::cerr << kind << "/" << engine.name << " output differs from the first engine for" << std::endl
+                  << text << "expected" << std::endl << expectedOutput << "got" << std::endl << output;
+
+        return false;
+    }
+
+    static void WriteFile(const std::filesystem::path& path, const std::string& text)
+    {
+        std::ofstream file(path);
+        file << text;
+    }
+
+    static std::string ReadFile(const std::filesystem::path& path)
+    {
+        std::ifstream file(path);
+        std::stringstream ss;
+        ss << file.rdbuf();
+
+        return ss.str();
+    }
+
+    std::filesystem::path m_inputFile;
+    std::filesystem::path m_outputFile;
+    std::vector<Engine> m_mealyEngines;
+    std::vector<Engine> m_mooreEngines;
+    size_t m_lazyWordsCount = 0;
+    size_t m_lazyFlushesCount = 0;
+};
+
+#ifdef MIM_LIBFUZZER
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    static DifferentialHarness harness;
+
+    BytesSource source(data, size);
+    TableGenerator generator(source, 32);
+    std::vector<std::vector<std::string>> words;
+    uint32_t kind = source.Next(4);
+    bool isEqual = kind == 0   ? harness.CheckMealy(generator.GenerateMealy())
+                   : kind == 1 ? harness.CheckMoore(generator.GenerateMoore())
+                   : kind == 2 ? harness.CheckProducts(generator.GenerateMoore(), generator.GenerateMoore())
+                               : harness.CheckLazyDfa(generator.GenerateNfa(words), words);
+
+    if (!isEqual)
+    {
+        abort();
+    }
+
+    return 0;
+}
+
+#else
+
+int main(int argc, char* argv[])
+{
+    std::map<std::string, uint64_t> options = {{"iterations", 1000}, {"seed", 1}, {"max-states", 32}};
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        auto pos = argument.find('=');
+        if (!argument.starts_with("--") || pos == std::string::npos || !options.contains(argument.substr(2, pos - 2)))
+        {
+            std::cerr << "Usage: " << argv[0] << " [--iterations=N] [--seed=N] [--max-states=N]" << std::endl;
+            return 1;
+        }
+        options[argument.substr(2, pos - 2)] = std::stoull(argument.substr(pos + 1));
+    }
+
+    SeededSource source(options["seed"]);
+    TableGenerator generator(source, static_cast<uint32_t>(options["max-states"]));
+    DifferentialHarness harness;
+    std::vector<std::vector<std::string>> words;
+
+    for (uint64_t iteration = 0; iteration < options["iterations"]; ++iteration)
+    {
+        if (!harness.CheckMealy(generator.GenerateMealy()) || !harness.CheckMoore(generator.GenerateMoore()) ||
+            !harness.CheckProducts(generator.GenerateMoore(), generator.GenerateMoore()) ||
+            !harness.CheckLazyDfa(generator.GenerateNfa(words), words))
+        {
+            std::cerr << "Failed at iteration " << iteration << std::endl;
+            return 1;
+        }
+    }
+
+    harness.PrintThroughput();
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,222 @@
+// Benchmark of the NFA minimization engines.
+//
+// Compares the refinement path (subset construction, then MooreAutomata::Minimize)
+// with Brzozowski's double reversal on a generated corpus and on any acceptor tables
+// given on the command line. Prints the sizes and the time of every engine per case.
+
+#include "../Automata/BrzozowskiMinimizer.h"
+#include "../Automata/MooreAutomata.h"
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct BenchmarkCase
+{
+    std::string name;
+    std::string text;
+};
+
+class CorpusGenerator
+{
+public:
+    // Sparse random NFA, optionally with ε-moves.
+    static BenchmarkCase GenerateRandom(uint32_t statesCount, uint32_t inputsCount, bool hasEpsilon, uint64_t seed)
+    {
+        std::mt19937_64 random(seed);
+        std::vector<std::string> inputs;
+        for (uint32_t input = 0; input < inputsCount; ++input)
+        {
+            inputs.push_back("x" + std::to_string(input + 1));
+        }
+        if (hasEpsilon)
+        {
+            inputs.push_back(E_CLOSE);
+        }
+
+        std::vector<std::vector<std::vector<uint32_t>>> targets(inputs.size(),
+                                                                std::vector<std::vector<uint32_t>>(statesCount));
+        for (auto& row: targets)
+        {
+            bool isEpsilon = hasEpsilon && &row == &targets.back();
+            for (auto& cell: row)
+            {
+                uint32_t count = isEpsilon ? random() % 8 == 0 : random() % 3;
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    cell.push_back(static_cast<uint32_t>(random() % statesCount));
+                }
+            }
+        }
+
+        std::vector<bool> finalStates(statesCount);
+        for (uint32_t state = 0; state < statesCount; ++state)
+        {
+            finalStates[state] = state == statesCount - 1 || random() % 4 == 0;
+        }
+
+        std::string name = std::string(hasEpsilon ? "random-eps" : "random") + "-" + std::to_string(statesCount);
+        return {name, Print(inputs, targets, finalStates)};
+    }
+
+    // (a|b)* a (a|b)^(n-1): the subset construction needs 2^n states, the reversed NFA is deterministic.
+    static BenchmarkCase GenerateSuffix(uint32_t n)
+    {
+        std::vector<std::vector<std::vector<uint32_t>>> targets(2, std::vector<std::vector<uint32_t>>(n + 1));
+        targets[0][0] = {0, 1};
+        targets[1][0] = {0};
+        for (uint32_t state = 1; state < n; ++state)
+        {
+            targets[0][state] = {state + 1};
+            targets[1][state] = {state + 1};
+        }
+
+        std::vector<bool> finalStates(n + 1);
+        finalStates[n] = true;
+
+        return {"suffix-" + std::to_string(n), Print({"a", "b"}, targets, finalStates)};
+    }
+
+    // (a|b)^(n-1) a (a|b)*: deterministic forward, its reverse is the suffix language,
+    // so the first reversed determinization needs 2^n states.
+    static BenchmarkCase GeneratePrefix(uint32_t n)
+    {
+        std::vector<std::vector<std::vector<uint32_t>>> targets(2, std::vector<std::vector<uint32_t>>(n + 1));
+        for (uint32_t state = 0; state + 1 < n; ++state)
+        {
+            targets[0][state] = {state + 1};
+            targets[1][state] = {state + 1};
+        }
+        targets[0][n - 1] = {n};
+        targets[0][n] = {n};
+        targets[1][n] = {n};
+
+        std::vector<bool> finalStates(n + 1);
+        finalStates[n] = true;
+
+        return {"prefix-" + std::to_string(n), Print({"a", "b"}, targets, finalStates)};
+    }
+
+private:
+    static std::string Print(const std::vector<std::string>& inputs,
+                             const std::vector<std::vector<std::vector<uint32_t>>>& targets,
+                             const std::vector<bool>& finalStates)
+    {
+        std::string outputs;
+        std::string states;
+        for (size_t state = 0; state < finalStates.size(); ++state)
+        {
+            outputs += finalStates[state] ? ";F" : ";";
+            states += ";s" + std::to_string(state);
+        }
+
+        std::string text = outputs + "\n" + states + "\n";
+        for (size_t input = 0; input < inputs.size(); ++input)
+        {
+            text += inputs[input];
+            for (auto& cell: targets[input])
+            {
+                text += ";";
+                for (size_t i = 0; i < cell.size(); ++i)
+                {
+                    text += (i == 0 ? "s" : ",s") + std::to_string(cell[i]);
+                }
+            }
+            text += "\n";
+        }
+
+        return text;
+    }
+};
+
+struct EngineResult
+{
+    size_t states = 0;
+    double milliseconds = 0;
+};
+
+EngineResult Measure(const std::function<MooreAutomata()>& minimize)
+{
+    auto start = std::chrono::steady_clock::now();
+    MooreAutomata result = minimize();
+    auto finish = std::chrono::steady_clock::now();
+
+    return {result.GetStates().size(), std::chrono::duration<double, std::milli>(finish - start).count()};
+}
+
+void RunCase(const BenchmarkCase& benchmarkCase)
+{
+    MooreAutomata source;
+    std::istringstream input(benchmarkCase.text);
+    source.ReadFromStream(input);
+
+    size_t dfaStates = 0;
+    EngineResult refinement = Measure([&] {
+        MooreAutomata dfa = BrzozowskiMinimizer::Determinize(source);
+        dfaStates = dfa.GetStates().size();
+        dfa.Minimize();
+        return dfa;
+    });
+    EngineResult brzozowski = Measure([&] { return BrzozowskiMinimizer::Minimize(source); });
+
+    std::cout << std::left << std::setw(20) << benchmarkCase.name << std::right
+              << std::setw(8) << source.GetStates().size()
+              << std::setw(10) << dfaStates
+              << std::setw(10) << refinement.states << std::setw(12) << std::fixed << std::setprecision(2)
+              << refinement.milliseconds
+              << std::setw(10) << brzozowski.states << std::setw(12) << brzozowski.milliseconds << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<BenchmarkCase> corpus;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::ifstream file(argv[i]);
+        if (!file.is_open())
+        {
+            std::cerr << "Usage: " << argv[0] << " [moore.csv...]" << std::endl;
+            return 1;
+        }
+        std::stringstream ss;
+        ss << file.rdbuf();
+        corpus.push_back({argv[i], ss.str()});
+    }
+
+    for (uint32_t statesCount: {16, 24, 32, 40})
+    {
+        corpus.push_back(CorpusGenerator::GenerateRandom(statesCount, 2, false, statesCount));
+        corpus.push_back(CorpusGenerator::GenerateRandom(statesCount, 4, true, statesCount));
+    }
+    for (uint32_t n: {4, 8, 10, 12})
+    {
+        corpus.push_back(CorpusGenerator::GenerateSuffix(n));
+        corpus.push_back(CorpusGenerator::GeneratePrefix(n));
+    }
+
+    // The refinement column keeps states that cannot reach a final state, Brzozowski drops them.
+    std::cout << std::left << std::setw(20) << "case" << std::right << std::setw(8) << "nfa"
+              << std::setw(10) << "dfa" << std::setw(10) << "refine" << std::setw(12) << "refine ms"
+              << std::setw(10) << "brzozow" << std::setw(12) << "brzozow ms" << std::endl;
+
+    for (auto& benchmarkCase: corpus)
+    {
+        try
+        {
+            RunCase(benchmarkCase);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << benchmarkCase.name << ": " << e.what() << std::endl;
+        }
+    }
+
+    return 0;
+}